@@ -0,0 +1,96 @@
+#include "backpressure.hpp"
+
+#include <cstdio>
+
+static const char* const level_names[] = {"caught up", "falling behind", "decimating low-priority signals",
+                                          "spilling", "stalled"};
+
+BackpressureMonitor::BackpressureMonitor(TelemetryPublisher& publisher, StatsSegment& stats,
+                                         std::size_t queue_capacity, SpillRing* spill,
+                                         const BackpressureConfig& config)
+    : publisher_(publisher), stats_(stats), capacity_(queue_capacity), spill_(spill), config_(config) {}
+
+void BackpressureMonitor::set_config(const BackpressureConfig& config) {
+    std::size_t spill_capacity = config_.spill_capacity;
+    uint64_t check_ns = config_.check_ns;
+    config_ = config;
+    config_.spill_capacity = spill_capacity;
+    config_.check_ns = check_ns;
+    if (decimating_) publisher_.set_decimation(config_.decimate_keep);
+}
+
+ConsumerPressure BackpressureMonitor::classify(const ConsumerStats& consumer, bool lossless, std::size_t lag,
+                                               uint64_t now_ns) const {
+    uint64_t heartbeat = consumer.heartbeat_ns.load(std::memory_order_relaxed);
+    if (now_ns > heartbeat && now_ns - heartbeat > config_.stale_ns) return ConsumerPressure::STALLED;
+    if (lag >= config_.decimate_lag * capacity_) return lossless ? ConsumerPressure::SPILL : ConsumerPressure::DECIMATE;
+    if (lag >= config_.warn_lag * capacity_) return ConsumerPressure::WARN;
+    return ConsumerPressure::OK;
+}
+
+void BackpressureMonitor::report(int slot, ConsumerPressure level, std::size_t lag) {
+    const ConsumerStats& c = stats_.consumers[slot];
+    FILE* out = level == ConsumerPressure::OK ? stdout : stderr;
+    std::fprintf(out, "consumer %.*s (pid %d): %s, %zu behind (%.0f%% of the queue)\n",
+                 static_cast<int>(CONSUMER_NAME_LEN), c.name, pid_[slot], level_names[static_cast<int>(level)],
+                 lag, 100.0 * lag / capacity_);
+}
+
+void BackpressureMonitor::check(std::size_t write_idx, uint64_t now_ns) {
+    bool lossy_over = false;        // some lossy consumer is past decimate_lag
+    bool lossy_clear = true;        // every lossy consumer is under warn_lag
+    int spill_slot = -1;
+    bool keep_spill_slot = false;   // the current spill target is still a live lossless consumer
+
+    for (int i = 0; i < MAX_CONSUMERS; ++i) {
+        ConsumerStats& c = stats_.consumers[i];
+        int32_t pid = c.pid.load(std::memory_order_acquire);
+        if (pid == 0 || !consumer_alive(c)) {
+            pid_[i] = 0;
+            continue;
+        }
+        if (pid != pid_[i]) {
+            pid_[i] = pid;
+            level_[i] = ConsumerPressure::OK;
+        }
+
+        bool lossless = spill_ && (c.flags.load(std::memory_order_relaxed) & CONSUMER_LOSSLESS);
+        std::size_t pos = c.position.load(std::memory_order_relaxed);
+        std::size_t lag = write_idx > pos ? write_idx - pos : 0;
+        ConsumerPressure level = classify(c, lossless, lag, now_ns);
+
+        if (level != level_[i]) report(i, level, lag);
+        level_[i] = level;
+        c.pressure.store(static_cast<uint32_t>(level), std::memory_order_relaxed);
+
+        // a stalled lossless consumer may just be waiting on its disk, keep spilling for it;
+        // a stalled lossy one shouldn't cost everybody else their low-priority signals
+        if (lossless) {
+            if (spill_slot < 0) spill_slot = i;
+            if (i == spill_slot_) keep_spill_slot = true;
+        } else if (level == ConsumerPressure::DECIMATE) {
+            lossy_over = true;
+            lossy_clear = false;
+        } else if (level == ConsumerPressure::WARN) {
+            lossy_clear = false;
+        }
+    }
+
+    if (!decimating_ && lossy_over) {
+        decimating_ = true;
+        publisher_.set_decimation(config_.decimate_keep);
+    } else if (decimating_ && lossy_clear) {
+        decimating_ = false;
+        publisher_.set_decimation(1);
+    }
+
+    // the ring can only change hands once its reader is gone
+    if (keep_spill_slot) spill_slot = spill_slot_;
+    if (spill_slot != spill_slot_) {
+        // stop the publisher before the ring changes hands, then point both at the new consumer
+        publisher_.set_spill(nullptr, nullptr);
+        spill_->retarget(spill_slot);
+        if (spill_slot >= 0) publisher_.set_spill(spill_, &stats_.consumers[spill_slot]);
+        spill_slot_ = spill_slot;
+    }
+}
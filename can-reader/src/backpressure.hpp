@@ -0,0 +1,55 @@
+#ifndef FSAE_BACKPRESSURE_HPP
+#define FSAE_BACKPRESSURE_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include "config_types.hpp"
+#include "shared_memory.hpp"
+#include "telemetry_publisher.hpp"
+
+// samples the lag of every consumer registered in the stats segment and reacts per
+// BackpressureConfig: logs each consumer moving between pressure levels, decimates low-priority
+// signals while a lossy consumer is past decimate_lag (until every one is back under warn_lag),
+// and points the spill ring at the first live lossless consumer
+// runs on can-reader's main thread; the publisher is only touched when a decision changes
+class BackpressureMonitor {
+public:
+    // spill may be nullptr (spilling off); lossless consumers are then treated like the rest
+    BackpressureMonitor(TelemetryPublisher& publisher, StatsSegment& stats, std::size_t queue_capacity,
+                        SpillRing* spill, const BackpressureConfig& config);
+
+    BackpressureMonitor(const BackpressureMonitor&) = delete;
+    BackpressureMonitor& operator=(const BackpressureMonitor&) = delete;
+
+    // thresholds and decimate_keep from a reloaded config; spill_capacity and check_ns stay
+    void set_config(const BackpressureConfig& config);
+
+    // one sample: write_idx is the queue's current position, now_ns CLOCK_MONOTONIC
+    void check(std::size_t write_idx, uint64_t now_ns);
+
+    bool decimating() const { return decimating_; }
+
+    // consumer slot being spilled for, -1 for none
+    int spill_slot() const { return spill_slot_; }
+
+private:
+    ConsumerPressure classify(const ConsumerStats& consumer, bool lossless, std::size_t lag, uint64_t now_ns) const;
+
+    void report(int slot, ConsumerPressure level, std::size_t lag);
+
+    TelemetryPublisher& publisher_;
+    StatsSegment& stats_;
+    const std::size_t capacity_;
+    SpillRing* const spill_;
+    BackpressureConfig config_;
+
+    // per slot: level at the last sample and the pid it belonged to, to log only transitions
+    ConsumerPressure level_[MAX_CONSUMERS] = {};
+    int32_t pid_[MAX_CONSUMERS] = {};
+
+    bool decimating_ = false;
+    int spill_slot_ = -1;
+};
+
+#endif
@@ -0,0 +1,269 @@
+#include "bus_reader.hpp"
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <system_error>
+
+#include "can_filter.hpp"
+#include "event_loop.hpp"
+
+// batches read per socket wakeup before the loop looks at its other sources again
+static constexpr int RX_BATCHES_PER_WAKEUP = 8;
+
+enum TraceEvent : uint32_t {
+    TRACE_FRAME_RX,     // id = CAN ID, arg = kernel RX time (CLOCK_REALTIME ns)
+    TRACE_SIGNAL        // id = CAN ID, arg = signal ID, value = decoded value
+};
+
+// runs on the trace drain thread; the signal table is append-only, so names can be read concurrently
+static void format_trace(const TraceRecord& rec, FILE* out, void* ctx) {
+    const SignalTable* signals = static_cast<const SignalTable*>(ctx);
+    switch (rec.event) {
+        case TRACE_FRAME_RX:
+            fprintf(out, "Received CAN frame with ID: %03x at %llu ns\n", rec.id,
+                    static_cast<unsigned long long>(rec.arg));
+            break;
+        case TRACE_SIGNAL: {
+            const SignalInfo* info = signals->info(static_cast<uint16_t>(rec.arg));
+            fprintf(out, "Parsed signal %u (%s) for CAN ID %03x: %f\n", static_cast<unsigned>(rec.arg),
+                    info ? info->name : "?", rec.id, rec.value);
+            break;
+        }
+    }
+}
+
+void BusIngest::set_decoder(std::unique_ptr<FrameDecoder> decoder) {
+    published_ns_.store(monotonic_ns(), std::memory_order_relaxed);
+    decoder_.publish(std::move(decoder));
+}
+
+void BusIngest::observe(const FrameDecoder* decoder, uint64_t generation) {
+    // by generation: a new decoder can be allocated at the address of the one in_use_ last was
+    if (generation != in_use_) {
+        // first pass over a new config: publish -> in use on the bus thread
+        uint64_t published = published_ns_.load(std::memory_order_relaxed);
+        uint64_t now = monotonic_ns();
+        if (in_use_) {
+            stat_add(stats_.config_swaps);
+            stat_set(stats_.swap_latency_ns, now > published ? now - published : 0);
+        }
+        in_use_ = generation;
+        // a new config starts every gate fresh, so each signal goes out once after a reload
+        gates_.clear();
+    }
+
+    // process() indexes gates_ by entry.channel unchecked: one per channel of this decoder, always
+    std::size_t channels = decoder ? decoder->channel_count() : 0;
+    if (gates_.size() == channels) return;
+    gates_.clear();
+    gates_.resize(channels);
+    for (std::size_t i = 0; i < channels; ++i) {
+        gates_[i].policy = decoder->channel(static_cast<uint32_t>(i)).publish;
+    }
+}
+
+void BusIngest::sync() {
+    uint64_t generation;
+    const FrameDecoder* decoder = decoder_.enter(0, generation);
+    observe(decoder, generation);
+    decoder_.exit(0);
+}
+
+uint32_t BusIngest::process(const CanRxFrame* rx, int count) {
+    uint64_t generation;
+    const FrameDecoder* decoder = decoder_.enter(0, generation);
+    observe(decoder, generation);
+    if (!decoder) {
+        decoder_.exit(0);
+        return 0;
+    }
+
+    uint64_t batch_start = monotonic_ns();
+    staged_.clear();
+    staged_wall_.clear();
+    staged_queued_.clear();
+    uint32_t queued = 0;
+    uint64_t suppressed[PUBLISH_MODES] = {};
+
+    for (int i = 0; i < count; ++i) {
+        const canfd_frame& frame = rx[i].frame;
+
+        trace_.emit(TraceLevel::FRAMES, TRACE_FRAME_RX, frame.can_id, rx[i].rx_time_ns);
+
+        uint32_t decoded = decoder->decode(frame, [&](const DecodeEntry& entry, double value) {
+            PublishGate& gate = gates_[entry.channel];
+            bool admit = gate.admit(value, rx[i].rx_mono_ns);
+            if (admit) ++queued;
+            else ++suppressed[static_cast<int>(gate.policy.mode)];
+
+            // build telemetry message
+            TelemetryMessage msg;
+            msg.signal_id = entry.signal_id;
+            msg._pad = 0;
+            msg.queue_delay_ns = 0;
+            msg.value = value;
+            msg.ingest_ns = rx[i].rx_mono_ns;
+            staged_.push_back(msg);
+            staged_wall_.push_back(rx[i].rx_time_ns);
+            staged_queued_.push_back(admit);
+            if (!admit) return;
+            trace_.emit(TraceLevel::SIGNALS, TRACE_SIGNAL, frame.can_id, msg.signal_id, msg.value);
+        });
+        if (decoded == 0) stat_add(stats_.unknown_frames);
+    }
+    // staged messages are plain copies, the decoder isn't needed past this point
+    decoder_.exit(0);
+
+    publisher_.publish(staged_.data(), staged_wall_.data(), staged_.size(), staged_queued_.data());
+
+    uint64_t now = monotonic_ns();
+    stat_add(stats_.frames, count);
+    stat_add(stats_.signals, queued);
+    for (int m = 0; m < PUBLISH_MODES; ++m) {
+        if (suppressed[m]) stat_add(stats_.suppressed[m], suppressed[m]);
+    }
+    stat_add(stats_.parse_ns, now - batch_start);
+    stat_set(stats_.heartbeat_ns, now);
+    return queued;
+}
+
+BusReader::BusReader(const BusConfig& config, TelemetryPublisher& publisher, SignalTable& signals, BusStats& stats)
+    : config_(config), signals_(signals), stats_(stats), ingest_(publisher, stats, trace_) {
+    std::size_t len = std::min(config_.interface.size(), BUS_NAME_LEN - 1);
+    memcpy(stats_.interface, config_.interface.data(), len);
+    stats_.interface[len] = '\0';
+}
+
+BusReader::~BusReader() {
+    stop();
+    if (wake_fd_ != -1) ::close(wake_fd_);
+    stats_.interface[0] = '\0';
+}
+
+bool BusReader::open(const FrameMap& frames) {
+    auto decoder = std::make_unique<FrameDecoder>(frames);
+    if (!sock_.open(config_.interface, build_can_filters(frames))) return false;
+    if (!sock_.set_nonblocking(true)) return false;
+
+    if (!sock_.fd_frames()) {
+        for (const auto& [can_id, channels] : frames) {
+            if (!channels.empty() && channels.front().frame_bytes > CAN_MAX_DLEN) {
+                fprintf(stderr, "%s: CAN FD frames not supported, messages over 8 bytes will not be received\n",
+                        config_.interface.c_str());
+                break;
+            }
+        }
+    }
+
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wake_fd_ == -1) return false;
+
+    ingest_.set_decoder(std::move(decoder));
+    return true;
+}
+
+bool BusReader::start(TraceLevel trace_level) {
+    trace_.set_level(trace_level);
+    trace_.start(format_trace, &signals_);
+    try {
+        thread_ = std::thread(&BusReader::run, this);
+    } catch (const std::system_error&) {
+        trace_.stop();
+        return false;
+    }
+    return true;
+}
+
+void BusReader::stop() {
+    if (!thread_.joinable()) return;
+    stopping_.store(true, std::memory_order_relaxed);
+    wake();
+    thread_.join();
+    trace_.stop();
+}
+
+void BusReader::reload(const FrameMap& frames) {
+    // compiled on the caller's thread; the bus thread only ever sees a finished decoder
+    uint64_t start = monotonic_ns();
+    auto decoder = std::make_unique<FrameDecoder>(frames);
+    std::vector<can_filter> filters = build_can_filters(frames);
+    stat_set(stats_.compile_ns, monotonic_ns() - start);
+
+    ingest_.set_decoder(std::move(decoder));
+    wake();
+
+    // IDs the new config adds are filtered out until this lands; the decoder skips IDs it doesn't know
+    if (!sock_.set_filters(filters)) {
+        fprintf(stderr, "%s: failed to update CAN filters: %s\n", config_.interface.c_str(), strerror(errno));
+    }
+    ingest_.reclaim();
+}
+
+void BusReader::wake() {
+    uint64_t one = 1;
+    if (::write(wake_fd_, &one, sizeof(one)) != sizeof(one) && errno != EAGAIN) {
+        std::perror("Failed to wake bus thread");
+    }
+}
+
+void BusReader::run() {
+    std::string name = "can:" + config_.interface;
+    pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+
+    if (config_.cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(config_.cpu, &set);
+        int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (err != 0) {
+            fprintf(stderr, "%s: failed to pin to cpu %d: %s\n", config_.interface.c_str(), config_.cpu, strerror(err));
+        }
+    }
+
+    EventLoop loop;
+    CanRxFrame rx[CAN_RX_BATCH];
+
+    auto on_readable = [&](uint32_t) {
+        for (int b = 0; b < RX_BATCHES_PER_WAKEUP; ++b) {
+            int n = sock_.read_batch(rx, CAN_RX_BATCH);
+            if (n <= 0) break;
+            ingest_.process(rx, n);
+            // a short batch means the socket queue is empty
+            if (n < CAN_RX_BATCH) break;
+        }
+    };
+
+    // stop requests, and new configs on an otherwise idle bus
+    auto on_wake = [&](uint32_t) {
+        uint64_t count;
+        while (::read(wake_fd_, &count, sizeof(count)) == sizeof(count)) {}
+        if (stopping_.load(std::memory_order_relaxed)) loop.stop();
+        ingest_.sync();
+    };
+
+    // keeps the heartbeat fresh on a quiet bus; socket counters come from sysfs
+    auto on_tick = [&]() {
+        CanSocketStats st = sock_.stats();
+        stat_set(stats_.socket_overflows, st.overflowed);
+        stat_set(stats_.filter_rejects, st.rejected);
+        stat_set(stats_.heartbeat_ns, monotonic_ns());
+    };
+
+    if (!loop.ok() || !loop.add(sock_.fd(), EPOLLIN, on_readable) || !loop.add(wake_fd_, EPOLLIN, on_wake) ||
+        !loop.add_timer(std::chrono::seconds(1), on_tick)) {
+        fprintf(stderr, "%s: failed to set up event loop: %s\n", config_.interface.c_str(), strerror(errno));
+        return;
+    }
+    if (!loop.run()) {
+        fprintf(stderr, "%s: event loop failed: %s\n", config_.interface.c_str(), strerror(errno));
+    }
+}
@@ -0,0 +1,114 @@
+#ifndef FSAE_BUS_READER_HPP
+#define FSAE_BUS_READER_HPP
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "can_socket.hpp"
+#include "config_types.hpp"
+#include "frame_decoder.hpp"
+#include "publish_gate.hpp"
+#include "rcu_pointer.hpp"
+#include "telemetry_publisher.hpp"
+#include "trace_ring.hpp"
+
+// decode + publish for one bus, independent of where the frames come from
+// process() and sync() run on the bus thread; set_decoder() and reclaim() on one other thread
+class BusIngest {
+public:
+    BusIngest(TelemetryPublisher& publisher, BusStats& stats, TraceRing& trace)
+        : decoder_(1), publisher_(publisher), stats_(stats), trace_(trace) {}
+
+    // publish a new decoder; the bus thread switches to it at its next batch or sync()
+    // without waiting on anything, and the old one is freed later by reclaim()
+    void set_decoder(std::unique_ptr<FrameDecoder> decoder);
+
+    // free decoders the bus thread can no longer be using; returns how many are still pending
+    std::size_t reclaim() { return decoder_.reclaim(); }
+
+    // decode a batch of frames and publish it as one batch: every signal to the latest-value table
+    // and derived channels, the ones their publish policies let through to the queue as well
+    // returns the number of signals queued
+    uint32_t process(const CanRxFrame* rx, int count);
+
+    // pass through a quiescent point without frames, so an idle bus picks up a new config
+    void sync();
+
+private:
+    // record the switch to a newly published decoder and reset the publish gates, keeping one
+    // gate per decoder channel; bus thread only
+    void observe(const FrameDecoder* decoder, uint64_t generation);
+
+    RcuPointer<FrameDecoder> decoder_;
+    uint64_t in_use_ = 0;       // generation of the decoder the bus thread last used, 0 = none
+    std::atomic<uint64_t> published_ns_{0};
+    TelemetryPublisher& publisher_;
+    BusStats& stats_;
+    TraceRing& trace_;
+
+    // one per decoder channel, indexed by DecodeEntry::channel
+    std::vector<PublishGate> gates_;
+
+    // reused across batches
+    std::vector<TelemetryMessage> staged_;
+    std::vector<uint64_t> staged_wall_;
+    std::vector<uint8_t> staged_queued_;
+};
+
+// one CAN interface read on its own thread, optionally pinned to a core
+class BusReader {
+public:
+    BusReader(const BusConfig& config, TelemetryPublisher& publisher, SignalTable& signals, BusStats& stats);
+    ~BusReader();
+
+    BusReader(const BusReader&) = delete;
+    BusReader& operator=(const BusReader&) = delete;
+
+    // open the interface filtered to the configured frames and compile the decoder
+    // returns false with errno set if the socket can't be opened; throws like FrameDecoder
+    bool open(const FrameMap& frames);
+
+    // start the reader thread
+    bool start(TraceLevel trace_level);
+
+    // stop and join the reader thread
+    void stop();
+
+    // compile a new config here, on the caller's thread, and publish it to the bus thread,
+    // which switches to it between batches; throws like FrameDecoder and keeps the old config
+    void reload(const FrameMap& frames);
+
+    // free configs the bus thread has moved past; call periodically from the reload thread
+    void reclaim() { ingest_.reclaim(); }
+
+    void set_trace_level(TraceLevel level) { trace_.set_level(level); }
+
+    const BusConfig& config() const { return config_; }
+
+    // socket counters; only meaningful once the thread is stopped
+    CanSocketStats socket_stats() const { return sock_.stats(); }
+
+    uint64_t trace_drops() const { return trace_.dropped(); }
+
+    const BusStats& stats() const { return stats_; }
+
+private:
+    void run();
+
+    void wake();
+
+    BusConfig config_;
+    SignalTable& signals_;
+    BusStats& stats_;
+    CanSocket sock_;
+    TraceRing trace_;
+    BusIngest ingest_;
+
+    int wake_fd_ = -1;
+    std::atomic<bool> stopping_{false};
+    std::thread thread_;
+};
+
+#endif
@@ -0,0 +1,53 @@
+#include "can_filter.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+// emit the fewest aligned power-of-two blocks that cover sorted, unique ids exactly
+static void collapse(const std::vector<uint32_t>& ids, uint32_t id_mask, uint32_t flags,
+                     std::vector<can_filter>& out) {
+    std::size_t i = 0;
+    while (i < ids.size()) {
+        uint32_t base = ids[i];
+
+        // length of the consecutive run starting here
+        std::size_t run = 1;
+        while (i + run < ids.size() && ids[i + run] == base + run) ++run;
+
+        // largest block that is aligned at base and fits inside the run
+        uint32_t block = 1;
+        while (block * 2 <= run && (base & (block * 2 - 1)) == 0 && block * 2 - 1 <= id_mask) {
+            block *= 2;
+        }
+
+        can_filter f;
+        f.can_id   = base | flags;
+        // match id bits above the block, the frame format bit, and reject remote frames
+        f.can_mask = (id_mask & ~(block - 1)) | CAN_EFF_FLAG | CAN_RTR_FLAG;
+        out.push_back(f);
+
+        i += block;
+    }
+}
+
+std::vector<can_filter> build_can_filters(const FrameMap& frames) {
+    std::vector<uint32_t> standard;
+    std::vector<uint32_t> extended;
+
+    for (const auto& [id, channels] : frames) {
+        if (id & CAN_EFF_FLAG) extended.push_back(id & CAN_EFF_MASK);
+        else standard.push_back(id & CAN_SFF_MASK);
+    }
+
+    std::sort(standard.begin(), standard.end());
+    standard.erase(std::unique(standard.begin(), standard.end()), standard.end());
+    std::sort(extended.begin(), extended.end());
+    extended.erase(std::unique(extended.begin(), extended.end()), extended.end());
+
+    std::vector<can_filter> filters;
+    collapse(standard, CAN_SFF_MASK, 0, filters);
+    collapse(extended, CAN_EFF_MASK, CAN_EFF_FLAG, filters);
+
+    if (filters.size() > CAN_FILTER_MAX) filters.clear();
+    return filters;
+}
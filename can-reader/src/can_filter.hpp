@@ -0,0 +1,17 @@
+#ifndef FSAE_CAN_FILTER_HPP
+#define FSAE_CAN_FILTER_HPP
+
+#include <linux/can.h>
+#include <vector>
+
+#include "config_types.hpp"
+
+// kernel limit on CAN_RAW_FILTER entries per socket (CAN_RAW_FILTER_MAX)
+inline constexpr std::size_t CAN_FILTER_MAX = 512;
+
+// build CAN_RAW_FILTER rules accepting exactly the IDs in the frame map
+// runs of consecutive IDs are collapsed into aligned id/mask blocks
+// returns an empty list (accept everything) if the rules would exceed CAN_FILTER_MAX
+std::vector<can_filter> build_can_filters(const FrameMap& frames);
+
+#endif
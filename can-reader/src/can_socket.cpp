@@ -3,10 +3,22 @@
 #include <sys/ioctl.h>
 #include <net/if.h>
 #include <linux/can/raw.h>
+#include <fcntl.h>
+#include <cerrno>
+#include <cstdio>
 #include <cstring>
+#include <fstream>
 #include <unistd.h>
 
-bool CanSocket::open(const std::string& interface) {
+// total frames the interface has received, whether or not this socket accepted them
+static uint64_t interface_rx_packets(const std::string& interface) {
+    std::ifstream f("/sys/class/net/" + interface + "/statistics/rx_packets");
+    uint64_t count = 0;
+    f >> count;
+    return count;
+}
+
+bool CanSocket::open(const std::string& interface, const std::vector<can_filter>& filters) {
     fd_ = socket(PF_CAN, SOCK_RAW, CAN_RAW);
 
     if(fd_ == -1) return false;
@@ -19,6 +31,26 @@ bool CanSocket::open(const std::string& interface) {
         return false;
     }
 
+    // kernel stamps each frame on RX, delivered as a cmsg by read_batch; without it frames are
+    // stamped when read_batch returns them, which adds the wakeup delay to every latency figure
+    int enable = 1;
+    if (setsockopt(fd_, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable)) == -1) {
+        std::fprintf(stderr, "%s: no kernel RX timestamps (%s), stamping frames on read\n",
+                     interface.c_str(), strerror(errno));
+    }
+
+    // running count of receive queue drops, also delivered as a cmsg
+    setsockopt(fd_, SOL_SOCKET, SO_RXQ_OVFL, &enable, sizeof(enable));
+
+    // accept CAN FD frames alongside classic ones; older kernels refuse and we stay classic-only
+    fd_frames_ = setsockopt(fd_, SOL_CAN_RAW, CAN_RAW_FD_FRAMES, &enable, sizeof(enable)) == 0;
+
+    // filters go on before bind so no unwanted frame is ever queued
+    if (!set_filters(filters)) {
+        close();
+        return false;
+    }
+
     struct sockaddr_can addr{};
     addr.can_family = AF_CAN;
     addr.can_ifindex = ifr.ifr_ifindex;
@@ -27,15 +59,110 @@ bool CanSocket::open(const std::string& interface) {
         return false;
     }
 
+    interface_ = interface;
+    bus_base_ = interface_rx_packets(interface);
+    delivered_ = 0;
+    overflowed_ = 0;
     return true;
 }
 
+bool CanSocket::set_filters(const std::vector<can_filter>& filters) {
+    if (filters.empty()) {
+        can_filter all{0, 0};
+        return setsockopt(fd_, SOL_CAN_RAW, CAN_RAW_FILTER, &all, sizeof(all)) == 0;
+    }
+    return setsockopt(fd_, SOL_CAN_RAW, CAN_RAW_FILTER, filters.data(),
+                      filters.size() * sizeof(can_filter)) == 0;
+}
+
 bool CanSocket::read(can_frame& frame) {
 
     int nbytes = ::read(fd_, &frame, sizeof(struct can_frame));
     return nbytes == sizeof(frame);
 }
 
+static uint64_t to_ns(const timespec& ts) {
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+int CanSocket::read_batch(CanRxFrame* frames, int max) {
+    if (max > CAN_RX_BATCH) max = CAN_RX_BATCH;
+
+    // the kernel rewrites msg_controllen, so the headers are reset every call
+    for (int i = 0; i < max; ++i) {
+        iovs_[i].iov_base = &frames[i].frame;
+        iovs_[i].iov_len = CANFD_MTU;
+
+        msghdr& hdr = msgs_[i].msg_hdr;
+        hdr.msg_name = nullptr;
+        hdr.msg_namelen = 0;
+        hdr.msg_iov = &iovs_[i];
+        hdr.msg_iovlen = 1;
+        hdr.msg_control = ctrl_[i];
+        hdr.msg_controllen = sizeof(ctrl_[i]);
+        hdr.msg_flags = 0;
+    }
+
+    // MSG_WAITFORONE: block for the first frame, then take whatever else is queued
+    int n = recvmmsg(fd_, msgs_, max, MSG_WAITFORONE, nullptr);
+    if (n <= 0) return n;
+
+    // one clock pair per batch maps kernel stamps onto CLOCK_MONOTONIC
+    timespec now{}, mono{};
+    clock_gettime(CLOCK_REALTIME, &now);
+    clock_gettime(CLOCK_MONOTONIC, &mono);
+    uint64_t now_ns = to_ns(now);
+    uint64_t mono_ns = to_ns(mono);
+
+    int out = 0;
+    for (int i = 0; i < n; ++i) {
+        // CAN_MTU for classic frames, CANFD_MTU for FD; both share the header layout
+        if (msgs_[i].msg_len != CAN_MTU && msgs_[i].msg_len != CANFD_MTU) continue;
+
+        uint64_t stamp = 0;
+        msghdr& hdr = msgs_[i].msg_hdr;
+        for (cmsghdr* c = CMSG_FIRSTHDR(&hdr); c; c = CMSG_NXTHDR(&hdr, c)) {
+            if (c->cmsg_level != SOL_SOCKET) continue;
+            if (c->cmsg_type == SO_TIMESTAMPNS) {
+                timespec ts;
+                memcpy(&ts, CMSG_DATA(c), sizeof(ts));
+                stamp = to_ns(ts);
+            } else if (c->cmsg_type == SO_RXQ_OVFL) {
+                uint32_t dropped;
+                memcpy(&dropped, CMSG_DATA(c), sizeof(dropped));
+                overflowed_ = dropped;
+            }
+        }
+        // no kernel stamp (option refused at open, or by the driver) - fall back to receive time
+        if (stamp == 0 || stamp > now_ns) stamp = now_ns;
+
+        if (out != i) frames[out].frame = frames[i].frame;
+        frames[out].rx_time_ns = stamp;
+        frames[out].rx_mono_ns = mono_ns - (now_ns - stamp);
+        ++out;
+    }
+
+    delivered_ += out;
+    return out;
+}
+
+bool CanSocket::set_nonblocking(bool nonblocking) {
+    int flags = fcntl(fd_, F_GETFL);
+    if (flags == -1) return false;
+    flags = nonblocking ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK);
+    return fcntl(fd_, F_SETFL, flags) == 0;
+}
+
+CanSocketStats CanSocket::stats() const {
+    CanSocketStats s;
+    s.delivered = delivered_;
+    s.overflowed = overflowed_;
+    uint64_t bus = interface_rx_packets(interface_) - bus_base_;
+    uint64_t accepted = delivered_ + overflowed_;
+    s.rejected = bus > accepted ? bus - accepted : 0;
+    return s;
+}
+
 void CanSocket::close() {
     ::close(fd_);
     fd_ = -1;
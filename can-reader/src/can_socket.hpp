@@ -2,7 +2,29 @@
 #define FSAE_CAN_SOCKET_HPP
 
 #include <linux/can.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <cstdint>
 #include <string>
+#include <vector>
+
+// max frames pulled from the kernel per recvmmsg call
+inline constexpr int CAN_RX_BATCH = 64;
+
+// a received frame and the kernel RX timestamp
+// classic frames land here too: their len is the DLC and bytes past it are left over
+struct CanRxFrame {
+    canfd_frame frame;
+    uint64_t rx_time_ns;    // CLOCK_REALTIME ns, for logs
+    uint64_t rx_mono_ns;    // same instant on CLOCK_MONOTONIC, for latency
+};
+
+struct CanSocketStats {
+    uint64_t delivered;   // frames handed to userspace by read_batch
+    uint64_t overflowed;  // frames dropped because the socket receive queue was full
+    uint64_t rejected;    // frames seen on the interface but dropped by the socket filters
+};
 
 class CanSocket {
 public:
@@ -19,14 +41,45 @@ public:
 
     CanSocket& operator=(const CanSocket&) = delete;
 
-    bool open(const std::string& interface);
+    // an empty filter list receives every frame on the bus
+    // CAN FD frames are enabled where the interface supports them
+    bool open(const std::string& interface, const std::vector<can_filter>& filters = {});
+
+    // replace the kernel-side CAN_RAW_FILTER rules
+    bool set_filters(const std::vector<can_filter>& filters);
 
     bool read(can_frame& frame);
 
+    // read up to max (<= CAN_RX_BATCH) frames with one syscall, blocking until at least one arrives
+    // returns the number of frames read, or -1 on error (errno set, EINTR on signal,
+    // EAGAIN if the socket is non-blocking and nothing is queued)
+    int read_batch(CanRxFrame* frames, int max);
+
+    // for event loops: poll fd() and read_batch until EAGAIN
+    bool set_nonblocking(bool nonblocking);
+
+    int fd() const { return fd_; }
+
     void close();
 
+    // counters since open; rejected is derived from the interface rx_packets statistic
+    CanSocketStats stats() const;
+
+    // whether CAN_RAW_FD_FRAMES was accepted by the kernel
+    bool fd_frames() const { return fd_frames_; }
+
 private:
     int fd_ = -1;
+    std::string interface_;
+    bool fd_frames_ = false;
+    uint64_t bus_base_ = 0;
+    uint64_t delivered_ = 0;
+    uint64_t overflowed_ = 0;
+
+    // recvmmsg scratch, reused across calls
+    mmsghdr msgs_[CAN_RX_BATCH];
+    iovec iovs_[CAN_RX_BATCH];
+    alignas(cmsghdr) char ctrl_[CAN_RX_BATCH][CMSG_SPACE(sizeof(timespec)) + CMSG_SPACE(sizeof(uint32_t))];
 };
 
 #endif
@@ -0,0 +1,365 @@
+#include "derived_channels.hpp"
+
+#include <linux/can.h>
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+
+static double apply(DerivedOp op, double a, double b) {
+    switch (op) {
+        case DerivedOp::MOV:    return a;
+        case DerivedOp::ADD:    return a + b;
+        case DerivedOp::SUB:    return a - b;
+        case DerivedOp::MUL:    return a * b;
+        case DerivedOp::DIV:    return a / b;
+        case DerivedOp::NEG:    return -a;
+        case DerivedOp::ABS:    return std::fabs(a);
+        case DerivedOp::SQRT:   return std::sqrt(a);
+        case DerivedOp::MIN:    return a < b ? a : b;
+        case DerivedOp::MAX:    return a > b ? a : b;
+    }
+    return 0.0;
+}
+
+// recursive descent over one expression at a time, emitting straight into the engine
+// constant subexpressions are folded; every other node gets a fresh temporary register
+class DerivedCompiler {
+public:
+    DerivedCompiler(DerivedEngine& engine, const std::vector<FrameMap>& frame_maps) : engine_(engine) {
+        for (const auto& frames : frame_maps) {
+            for (const auto& [can_id, channels] : frames) {
+                for (const auto& cfg : channels) {
+                    if (cfg.signal_id == INVALID_SIGNAL_ID) continue;
+                    auto& found = by_name_[cfg.name];
+                    bool seen = std::any_of(found.begin(), found.end(),
+                                            [&](const auto& f) { return f.second == cfg.signal_id; });
+                    if (!seen) found.emplace_back(can_id, cfg.signal_id);
+                }
+            }
+        }
+    }
+
+    void compile(const DerivedConfig& cfg, uint16_t signal_id) {
+        src_ = &cfg.expr;
+        name_ = &cfg.name;
+        pos_ = 0;
+        leaves_.clear();
+        if (derived_regs_.count(cfg.name)) fail("defined twice");
+
+        DerivedProgram program;
+        program.code_begin = static_cast<uint32_t>(engine_.code_.size());
+        program.output = alloc(0.0, false);
+        program.signal_id = signal_id;
+
+        Operand result = parse_expr();
+        skip_space();
+        if (pos_ != src_->size()) fail("unexpected '" + src_->substr(pos_, 1) + "'");
+        if (leaves_.empty()) fail("reads no signals");
+
+        // the last instruction writes the output directly unless the result is a bare operand
+        auto& code = engine_.code_;
+        if (result.temp && code.size() > program.code_begin && code.back().dst == result.reg) {
+            code.back().dst = program.output;
+        } else {
+            code.push_back(DerivedInstr{DerivedOp::MOV, program.output, result.reg, result.reg});
+        }
+        program.code_count = static_cast<uint32_t>(code.size()) - program.code_begin;
+
+        uint32_t index = static_cast<uint32_t>(engine_.programs_.size());
+        program.missing = 0;
+        for (uint16_t reg : leaves_) {
+            readers_[reg].push_back(index);
+            if (!engine_.known_[reg]) ++program.missing;
+        }
+        engine_.programs_.push_back(program);
+        engine_.names_.push_back(cfg.name);
+        derived_regs_[cfg.name] = program.output;
+    }
+
+    // flatten the reader lists and size the per-channel state
+    void finish() {
+        engine_.reader_begin_.assign(1, 0);
+        for (const auto& readers : readers_) {
+            engine_.readers_.insert(engine_.readers_.end(), readers.begin(), readers.end());
+            engine_.reader_begin_.push_back(static_cast<uint32_t>(engine_.readers_.size()));
+        }
+        std::size_t n = engine_.programs_.size();
+        engine_.dirty_.assign(n, 0);
+        engine_.dirty_ns_.assign(n, 0);
+        engine_.dirty_wall_.assign(n, 0);
+    }
+
+private:
+    struct Operand {
+        uint16_t reg;
+        bool temp;          // holds an intermediate result rather than an input or constant
+        bool constant;
+        double value;       // when constant
+    };
+
+    [[noreturn]] void fail(const std::string& what) {
+        throw std::invalid_argument("derived channel '" + *name_ + "': " + what);
+    }
+
+    uint16_t alloc(double initial, bool known) {
+        if (engine_.regs_.size() >= UINT16_MAX) fail("too many registers");
+        engine_.regs_.push_back(initial);
+        engine_.known_.push_back(known ? 1 : 0);
+        readers_.emplace_back();
+        return static_cast<uint16_t>(engine_.regs_.size() - 1);
+    }
+
+    Operand constant(double value) {
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        auto it = const_regs_.find(bits);
+        uint16_t reg = it != const_regs_.end() ? it->second : (const_regs_[bits] = alloc(value, true));
+        return Operand{reg, false, true, value};
+    }
+
+    // a signal name, name@<hex CAN ID>, or an earlier derived channel
+    Operand variable(const std::string& ident, const std::string& id_text) {
+        uint16_t reg;
+        auto derived = derived_regs_.find(ident);
+        if (id_text.empty() && derived != derived_regs_.end()) {
+            reg = derived->second;
+        } else {
+            auto it = by_name_.find(ident);
+            if (it == by_name_.end()) fail("unknown signal '" + ident + "'");
+
+            std::vector<std::pair<uint32_t, uint16_t>> matches;
+            uint32_t want = id_text.empty() ? 0 : static_cast<uint32_t>(std::strtoul(id_text.c_str(), nullptr, 16));
+            for (const auto& [can_id, signal_id] : it->second) {
+                uint32_t id = can_id & CAN_EFF_FLAG ? can_id & CAN_EFF_MASK : can_id;
+                if (id_text.empty() || id == want) matches.emplace_back(can_id, signal_id);
+            }
+            if (matches.empty()) fail("no signal '" + ident + "' in frame " + id_text);
+            if (matches.size() > 1) fail("'" + ident + "' is in several frames, add @<CAN ID>");
+
+            uint16_t signal_id = matches.front().second;
+            auto input = input_regs_.find(signal_id);
+            if (input != input_regs_.end()) {
+                reg = input->second;
+            } else {
+                reg = input_regs_[signal_id] = alloc(0.0, false);
+                if (engine_.input_of_.size() <= signal_id) engine_.input_of_.resize(signal_id + 1u, 0);
+                engine_.input_of_[signal_id] = static_cast<uint16_t>(reg + 1);
+            }
+        }
+        if (std::find(leaves_.begin(), leaves_.end(), reg) == leaves_.end()) leaves_.push_back(reg);
+        return Operand{reg, false, false, 0.0};
+    }
+
+    Operand emit(DerivedOp op, Operand a, Operand b) {
+        if (a.constant && b.constant) return constant(apply(op, a.value, b.value));
+        uint16_t dst = alloc(0.0, true);
+        engine_.code_.push_back(DerivedInstr{op, dst, a.reg, b.reg});
+        return Operand{dst, true, false, 0.0};
+    }
+
+    void skip_space() {
+        while (pos_ < src_->size() && std::isspace(static_cast<unsigned char>((*src_)[pos_]))) ++pos_;
+    }
+
+    bool accept(char c) {
+        skip_space();
+        if (pos_ < src_->size() && (*src_)[pos_] == c) {
+            ++pos_;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char c) {
+        if (!accept(c)) fail(std::string("expected '") + c + "'");
+    }
+
+    // expr := term (('+' | '-') term)*
+    Operand parse_expr() {
+        Operand left = parse_term();
+        for (;;) {
+            if (accept('+'))      left = emit(DerivedOp::ADD, left, parse_term());
+            else if (accept('-')) left = emit(DerivedOp::SUB, left, parse_term());
+            else return left;
+        }
+    }
+
+    // term := unary (('*' | '/') unary)*
+    Operand parse_term() {
+        Operand left = parse_unary();
+        for (;;) {
+            if (accept('*'))      left = emit(DerivedOp::MUL, left, parse_unary());
+            else if (accept('/')) left = emit(DerivedOp::DIV, left, parse_unary());
+            else return left;
+        }
+    }
+
+    // unary := '-' unary | primary
+    Operand parse_unary() {
+        if (accept('-')) {
+            Operand a = parse_unary();
+            return emit(DerivedOp::NEG, a, a);
+        }
+        return parse_primary();
+    }
+
+    // primary := number | '(' expr ')' | function '(' args ')' | name ['@' hex]
+    Operand parse_primary() {
+        if (accept('(')) {
+            Operand inner = parse_expr();
+            expect(')');
+            return inner;
+        }
+
+        skip_space();
+        if (pos_ >= src_->size()) fail("unexpected end of expression");
+        const char* begin = src_->c_str() + pos_;
+        char c = *begin;
+
+        if (std::isdigit(static_cast<unsigned char>(c)) || c == '.') {
+            char* end;
+            double value = std::strtod(begin, &end);
+            if (end == begin) fail("bad number");
+            pos_ += static_cast<std::size_t>(end - begin);
+            return constant(value);
+        }
+
+        if (!std::isalpha(static_cast<unsigned char>(c)) && c != '_') fail(std::string("unexpected '") + c + "'");
+        std::size_t start = pos_;
+        while (pos_ < src_->size() && (std::isalnum(static_cast<unsigned char>((*src_)[pos_])) || (*src_)[pos_] == '_')) {
+            ++pos_;
+        }
+        std::string ident = src_->substr(start, pos_ - start);
+
+        if (accept('(')) return parse_call(ident);
+
+        std::string id_text;
+        if (pos_ < src_->size() && (*src_)[pos_] == '@') {
+            start = ++pos_;
+            if (src_->compare(pos_, 2, "0x") == 0 || src_->compare(pos_, 2, "0X") == 0) start = pos_ += 2;
+            while (pos_ < src_->size() && std::isxdigit(static_cast<unsigned char>((*src_)[pos_]))) ++pos_;
+            id_text = src_->substr(start, pos_ - start);
+            if (id_text.empty()) fail("expected a hex CAN ID after '@'");
+        }
+        return variable(ident, id_text);
+    }
+
+    Operand parse_call(const std::string& fn) {
+        Operand a = parse_expr();
+        if (fn == "abs" || fn == "sqrt") {
+            expect(')');
+            return emit(fn == "abs" ? DerivedOp::ABS : DerivedOp::SQRT, a, a);
+        }
+        if (fn == "min" || fn == "max") {
+            expect(',');
+            Operand b = parse_expr();
+            expect(')');
+            return emit(fn == "min" ? DerivedOp::MIN : DerivedOp::MAX, a, b);
+        }
+        fail("unknown function '" + fn + "'");
+    }
+
+    DerivedEngine& engine_;
+    std::unordered_map<std::string, std::vector<std::pair<uint32_t, uint16_t>>> by_name_;
+    std::unordered_map<std::string, uint16_t> derived_regs_;
+    std::unordered_map<uint16_t, uint16_t> input_regs_;
+    std::unordered_map<uint64_t, uint16_t> const_regs_;
+    std::vector<std::vector<uint32_t>> readers_;
+
+    // expression being compiled and the distinct non-constant registers it reads
+    const std::string* src_ = nullptr;
+    const std::string* name_ = nullptr;
+    std::size_t pos_ = 0;
+    std::vector<uint16_t> leaves_;
+};
+
+DerivedEngine::DerivedEngine(const std::vector<DerivedConfig>& derived, const std::vector<FrameMap>& frame_maps,
+                             SignalTable& signals) {
+    DerivedCompiler compiler(*this, frame_maps);
+    for (const auto& cfg : derived) {
+        uint16_t signal_id = signals.intern(DERIVED_CAN_ID, cfg.name);
+        if (signal_id == INVALID_SIGNAL_ID) {
+            throw std::invalid_argument("derived channel '" + cfg.name + "': signal table full");
+        }
+        compiler.compile(cfg, signal_id);
+    }
+    compiler.finish();
+}
+
+void DerivedEngine::know(uint16_t reg) {
+    known_[reg] = 1;
+    for (uint32_t i = reader_begin_[reg]; i < reader_begin_[reg + 1]; ++i) --programs_[readers_[i]].missing;
+}
+
+void DerivedEngine::touch(uint16_t reg, uint64_t ingest_ns, uint64_t wall_ns) {
+    for (uint32_t i = reader_begin_[reg]; i < reader_begin_[reg + 1]; ++i) {
+        uint32_t c = readers_[i];
+        dirty_[c] = 1;
+        dirty_ns_[c] = std::max(dirty_ns_[c], ingest_ns);
+        dirty_wall_[c] = std::max(dirty_wall_[c], wall_ns);
+        first_dirty_ = std::min(first_dirty_, c);
+    }
+}
+
+void DerivedEngine::update(const TelemetryMessage* msgs, const uint64_t* wall_ns, std::size_t count) {
+    std::size_t inputs = input_of_.size();
+    for (std::size_t i = 0; i < count; ++i) {
+        uint16_t id = msgs[i].signal_id;
+        if (id >= inputs || input_of_[id] == 0) continue;
+
+        uint16_t reg = input_of_[id] - 1;
+        double value = msgs[i].value;
+        if (known_[reg] && regs_[reg] == value) continue;
+        regs_[reg] = value;
+        if (!known_[reg]) know(reg);
+        touch(reg, msgs[i].ingest_ns, wall_ns[i]);
+    }
+}
+
+double DerivedEngine::run(const DerivedProgram& program) {
+    double* r = regs_.data();
+    const DerivedInstr* in = code_.data() + program.code_begin;
+    for (uint32_t i = 0; i < program.code_count; ++i, ++in) r[in->dst] = apply(in->op, r[in->a], r[in->b]);
+    return r[program.output];
+}
+
+std::size_t DerivedEngine::evaluate(std::vector<TelemetryMessage>& out, std::vector<uint64_t>& out_wall) {
+    std::size_t ran = 0;
+    // channels only read earlier ones, so one pass in order settles everything downstream
+    for (uint32_t c = first_dirty_; c < programs_.size(); ++c) {
+        if (!dirty_[c]) continue;
+        dirty_[c] = 0;
+        uint64_t ingest_ns = dirty_ns_[c], wall_ns = dirty_wall_[c];
+        dirty_ns_[c] = dirty_wall_[c] = 0;
+
+        const DerivedProgram& program = programs_[c];
+        if (program.missing) continue;
+
+        double before = regs_[program.output];
+        double value = run(program);
+        ++ran;
+        if (!std::isfinite(value)) {
+            regs_[program.output] = before;
+            continue;
+        }
+
+        TelemetryMessage msg;
+        msg.signal_id = program.signal_id;
+        msg._pad = 0;
+        msg.queue_delay_ns = 0;
+        msg.value = value;
+        msg.ingest_ns = ingest_ns;
+        out.push_back(msg);
+        out_wall.push_back(wall_ns);
+
+        bool first = !known_[program.output];
+        if (first) know(program.output);
+        if (first || value != before) touch(program.output, ingest_ns, wall_ns);
+    }
+    first_dirty_ = UINT32_MAX;
+    return ran;
+}
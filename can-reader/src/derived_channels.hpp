@@ -0,0 +1,91 @@
+#ifndef FSAE_DERIVED_CHANNELS_HPP
+#define FSAE_DERIVED_CHANNELS_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "config_types.hpp"
+#include "shared_memory.hpp"
+
+// one register-machine instruction; operands index DerivedEngine's register file
+enum class DerivedOp : uint8_t { MOV, ADD, SUB, MUL, DIV, NEG, ABS, SQRT, MIN, MAX };
+
+struct DerivedInstr {
+    DerivedOp op;
+    uint16_t dst;
+    uint16_t a;
+    uint16_t b;
+};
+
+// compiled form of one derived channel
+struct DerivedProgram {
+    uint32_t code_begin;
+    uint32_t code_count;
+    uint16_t output;        // register the result lands in
+    uint16_t signal_id;
+    uint16_t missing;       // operands never received yet; evaluated only once this reaches 0
+};
+
+// computed channels, compiled once per config load into bytecode over a shared register file
+// registers hold input signals, constants, results and temporaries; a channel is re-run only
+// when one of its operands changed, and channels defined later can read earlier results
+class DerivedEngine {
+public:
+    DerivedEngine() = default;
+
+    // compile every expression; names resolve against the interned signals in frame_maps and
+    // against derived channels defined earlier, which are interned under DERIVED_CAN_ID
+    // syntax: + - * / unary -, parentheses, abs(x), sqrt(x), min(a, b), max(a, b), numbers
+    // throws std::invalid_argument on syntax errors and unknown or ambiguous names
+    DerivedEngine(const std::vector<DerivedConfig>& derived, const std::vector<FrameMap>& frame_maps,
+                  SignalTable& signals);
+
+    // take in a batch of messages; inputs whose value changed mark the channels reading them
+    void update(const TelemetryMessage* msgs, const uint64_t* wall_ns, std::size_t count);
+
+    // run every channel with a changed operand, appending its result to out / out_wall
+    // non-finite results (e.g. dividing by a zero speed) are not published
+    // returns the number of channels run
+    std::size_t evaluate(std::vector<TelemetryMessage>& out, std::vector<uint64_t>& out_wall);
+
+    std::size_t channel_count() const { return programs_.size(); }
+
+    const std::string& name(std::size_t index) const { return names_[index]; }
+
+    uint16_t signal_id(std::size_t index) const { return programs_[index].signal_id; }
+
+    std::size_t instruction_count() const { return code_.size(); }
+
+private:
+    friend class DerivedCompiler;
+
+    double run(const DerivedProgram& program);
+
+    // register r changed at ingest_ns / wall_ns: mark every channel reading it
+    void touch(uint16_t reg, uint64_t ingest_ns, uint64_t wall_ns);
+
+    // register r holds a value for the first time
+    void know(uint16_t reg);
+
+    std::vector<double> regs_;
+    std::vector<uint8_t> known_;
+    std::vector<DerivedInstr> code_;
+    std::vector<DerivedProgram> programs_;
+    std::vector<std::string> names_;
+
+    // signal ID -> 1 + input register, 0 for signals no channel reads
+    std::vector<uint16_t> input_of_;
+
+    // channels reading register r: readers_[reader_begin_[r] .. reader_begin_[r + 1])
+    std::vector<uint32_t> reader_begin_;
+    std::vector<uint32_t> readers_;
+
+    // per channel: needs a run, and the newest input stamps that caused it
+    std::vector<uint8_t> dirty_;
+    std::vector<uint64_t> dirty_ns_;
+    std::vector<uint64_t> dirty_wall_;
+    uint32_t first_dirty_ = UINT32_MAX;
+};
+
+#endif
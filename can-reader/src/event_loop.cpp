@@ -0,0 +1,115 @@
+#include "event_loop.hpp"
+
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+
+// events handled per epoll_wait; anything beyond is picked up on the next call
+static constexpr int MAX_EVENTS = 16;
+
+EventLoop::EventLoop() {
+    epfd_ = epoll_create1(EPOLL_CLOEXEC);
+}
+
+EventLoop::~EventLoop() {
+    for (auto& src : sources_) {
+        if (src->live && src->owned) ::close(src->fd);
+    }
+    if (epfd_ != -1) ::close(epfd_);
+}
+
+bool EventLoop::watch(int fd, uint32_t events, bool owned, Handler handler) {
+    auto src = std::make_unique<Source>(Source{fd, owned, true, std::move(handler)});
+
+    epoll_event ev{};
+    ev.events = events;
+    ev.data.ptr = src.get();
+    if (epoll_ctl(epfd_, EPOLL_CTL_ADD, fd, &ev) == -1) return false;
+
+    sources_.push_back(std::move(src));
+    return true;
+}
+
+bool EventLoop::add(int fd, uint32_t events, Handler handler) {
+    return watch(fd, events, false, std::move(handler));
+}
+
+void EventLoop::remove(int fd) {
+    for (auto& src : sources_) {
+        if (!src->live || src->fd != fd) continue;
+        epoll_ctl(epfd_, EPOLL_CTL_DEL, fd, nullptr);
+        if (src->owned) ::close(fd);
+        // the Source itself stays until run() sweeps it, events for it may already be pending
+        src->live = false;
+    }
+}
+
+bool EventLoop::add_signals(std::initializer_list<int> signals, std::function<void(int signo)> handler) {
+    sigset_t mask;
+    sigemptyset(&mask);
+    for (int sig : signals) sigaddset(&mask, sig);
+    if (sigprocmask(SIG_BLOCK, &mask, nullptr) == -1) return false;
+
+    int fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (fd == -1) return false;
+
+    bool added = watch(fd, EPOLLIN, true, [fd, handler = std::move(handler)](uint32_t) {
+        signalfd_siginfo info;
+        while (::read(fd, &info, sizeof(info)) == sizeof(info)) {
+            handler(static_cast<int>(info.ssi_signo));
+        }
+    });
+    if (!added) ::close(fd);
+    return added;
+}
+
+bool EventLoop::add_timer(std::chrono::nanoseconds period, std::function<void()> handler) {
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd == -1) return false;
+
+    auto ns = period.count();
+    itimerspec spec{};
+    spec.it_interval.tv_sec = ns / 1000000000;
+    spec.it_interval.tv_nsec = ns % 1000000000;
+    spec.it_value = spec.it_interval;
+    if (timerfd_settime(fd, 0, &spec, nullptr) == -1) {
+        ::close(fd);
+        return false;
+    }
+
+    bool added = watch(fd, EPOLLIN, true, [fd, handler = std::move(handler)](uint32_t) {
+        // one call however many periods elapsed: housekeeping catches up, it doesn't replay
+        uint64_t expirations;
+        if (::read(fd, &expirations, sizeof(expirations)) == sizeof(expirations)) handler();
+    });
+    if (!added) ::close(fd);
+    return added;
+}
+
+bool EventLoop::run() {
+    running_ = true;
+    epoll_event events[MAX_EVENTS];
+
+    while (running_) {
+        int n = epoll_wait(epfd_, events, MAX_EVENTS, -1);
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+
+        for (int i = 0; i < n; ++i) {
+            Source* src = static_cast<Source*>(events[i].data.ptr);
+            if (src->live) src->handler(events[i].events);
+        }
+
+        // drop sources removed during this round now that no event can refer to them
+        sources_.erase(std::remove_if(sources_.begin(), sources_.end(),
+                                      [](const std::unique_ptr<Source>& s) { return !s->live; }),
+                       sources_.end());
+    }
+    return true;
+}
@@ -0,0 +1,58 @@
+#ifndef FSAE_EVENT_LOOP_HPP
+#define FSAE_EVENT_LOOP_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <vector>
+
+// epoll-based loop: file descriptors, a signalfd and timerfds all wake the same epoll_wait
+// every ready source is handled in each wakeup, in the order the kernel reports them
+class EventLoop {
+public:
+    using Handler = std::function<void(uint32_t events)>;
+
+    EventLoop();
+    ~EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    bool ok() const { return epfd_ != -1; }
+
+    // watch fd (level-triggered); the loop does not take ownership of fd
+    bool add(int fd, uint32_t events, Handler handler);
+
+    // stop watching fd; safe to call from inside a handler
+    void remove(int fd);
+
+    // block the signals for the whole process and deliver them through a signalfd instead
+    // call before starting any threads so they inherit the mask
+    bool add_signals(std::initializer_list<int> signals, std::function<void(int signo)> handler);
+
+    // call handler every period, first after one period
+    bool add_timer(std::chrono::nanoseconds period, std::function<void()> handler);
+
+    // dispatch until stop(); returns false if epoll_wait fails
+    bool run();
+
+    void stop() { running_ = false; }
+
+private:
+    struct Source {
+        int fd;
+        bool owned;     // signalfd/timerfd created here, closed on destruction
+        bool live;
+        Handler handler;
+    };
+
+    bool watch(int fd, uint32_t events, bool owned, Handler handler);
+
+    int epfd_ = -1;
+    bool running_ = false;
+    std::vector<std::unique_ptr<Source>> sources_;
+};
+
+#endif
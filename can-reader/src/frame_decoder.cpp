@@ -0,0 +1,170 @@
+#include "frame_decoder.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+template <SignalType Type, ByteOrder Order>
+static double extract(const FrameWords& words, const DecodeEntry& entry) {
+    uint64_t word = Order == ByteOrder::INTEL ? words.intel : words.motorola;
+    uint64_t raw = (word >> entry.plan.shift) & entry.plan.mask;
+
+    double value;
+    if constexpr (Type == SignalType::UNSIGNED) {
+        value = static_cast<double>(raw);
+    } else if constexpr (Type == SignalType::SIGNED) {
+        value = static_cast<double>(static_cast<int64_t>((raw ^ entry.plan.sign) - entry.plan.sign));
+    } else if constexpr (Type == SignalType::FLOAT) {
+        uint32_t bits = static_cast<uint32_t>(raw);
+        float f;
+        memcpy(&f, &bits, sizeof(f));
+        value = f;
+    } else {
+        memcpy(&value, &raw, sizeof(value));
+    }
+    return value * entry.scale + entry.offset;
+}
+
+template <SignalType Type>
+static ExtractFn pick(ByteOrder order) {
+    return order == ByteOrder::INTEL ? &extract<Type, ByteOrder::INTEL>
+                                     : &extract<Type, ByteOrder::MOTOROLA>;
+}
+
+static ExtractFn select_extractor(const ChannelConfig& cfg) {
+    switch (cfg.type) {
+        case SignalType::UNSIGNED:  return pick<SignalType::UNSIGNED>(cfg.byte_order);
+        case SignalType::SIGNED:    return pick<SignalType::SIGNED>(cfg.byte_order);
+        case SignalType::FLOAT:     return pick<SignalType::FLOAT>(cfg.byte_order);
+        case SignalType::DOUBLE:    return pick<SignalType::DOUBLE>(cfg.byte_order);
+    }
+    return nullptr;
+}
+
+FrameDecoder::FrameDecoder(const FrameMap& frames) : standard_(CAN_SFF_MASK + 1, FrameSlot{0, 0, 0, 0, 0}) {
+    std::vector<std::pair<uint32_t, FrameSlot>> extended;
+
+    for (const auto& [can_id, channels] : frames) {
+        if (can_id <= CAN_SFF_MASK) {
+            add_frame(channels, standard_[can_id]);
+        } else if ((can_id & (CAN_EFF_FLAG | CAN_RTR_FLAG | CAN_ERR_FLAG)) == CAN_EFF_FLAG) {
+            FrameSlot slot;
+            add_frame(channels, slot);
+            extended.emplace_back(can_id, slot);
+        } else {
+            throw std::invalid_argument("invalid CAN ID in config: " + std::to_string(can_id));
+        }
+    }
+
+    build_extended_hash(extended);
+}
+
+void FrameDecoder::add_frame(const std::vector<ChannelConfig>& channels, FrameSlot& slot) {
+    std::vector<uint32_t> always;
+    std::vector<std::vector<uint32_t>> pages;
+    const ChannelConfig* selector = nullptr;
+
+    for (const auto& cfg : channels) {
+        uint32_t index = static_cast<uint32_t>(channels_.size());
+        channels_.push_back(cfg);
+
+        if (cfg.mux != MuxRole::MULTIPLEXED) {
+            if (cfg.mux == MuxRole::MULTIPLEXOR) {
+                if (selector) throw std::invalid_argument("signal '" + cfg.name + "' is a second multiplexor");
+                selector = &cfg;
+            }
+            always.push_back(index);
+            continue;
+        }
+        if (cfg.mux_value >= pages.size()) pages.resize(cfg.mux_value + 1u);
+        pages[cfg.mux_value].push_back(index);
+    }
+
+    slot = add_run(always);
+    if (pages.empty()) return;
+    if (!selector) {
+        throw std::invalid_argument("multiplexed signals without a multiplexor in frame with '" +
+                                    channels.front().name + "'");
+    }
+
+    // one slot per mux value up to the highest configured, so decode indexes it without searching
+    MuxTable mux;
+    mux.plan = make_bit_plan(*selector);
+    mux.plan.sign = 0;
+    mux.order = selector->byte_order;
+    mux.page_begin = static_cast<uint32_t>(pages_.size());
+    mux.page_count = static_cast<uint32_t>(pages.size());
+    for (const auto& page : pages) pages_.push_back(add_run(page));
+
+    muxes_.push_back(mux);
+    slot.mux = static_cast<uint32_t>(muxes_.size());
+}
+
+FrameSlot FrameDecoder::add_run(const std::vector<uint32_t>& indices) {
+    FrameSlot run{static_cast<uint32_t>(entries_.size()), static_cast<uint32_t>(indices.size()),
+                  static_cast<uint32_t>(windows_.size()), 0, 0};
+
+    std::vector<DecodeEntry> run_entries;
+    for (uint32_t index : indices) {
+        const ChannelConfig& cfg = channels_[index];
+        DecodeEntry e;
+        e.extract = select_extractor(cfg);
+        e.plan    = make_bit_plan(cfg);
+        e.scale   = cfg.scale;
+        e.offset  = cfg.offset;
+        e.channel = index;
+        e.signal_id = cfg.signal_id;
+        run_entries.push_back(e);
+    }
+
+    // group by window so decode loads each one once; channel order is kept within a window
+    std::stable_sort(run_entries.begin(), run_entries.end(),
+                     [](const DecodeEntry& a, const DecodeEntry& b) { return a.plan.base < b.plan.base; });
+    for (const auto& e : run_entries) {
+        if (run.window_count == 0 || windows_.back().base != e.plan.base) {
+            windows_.push_back(WindowRun{e.plan.base, 0});
+            ++run.window_count;
+        }
+        ++windows_.back().count;
+        entries_.push_back(e);
+    }
+    return run;
+}
+
+// multiplicative hash: search for a multiplier that maps every key to its own slot
+void FrameDecoder::build_extended_hash(const std::vector<std::pair<uint32_t, FrameSlot>>& extended) {
+    if (extended.empty()) return;
+
+    uint32_t bits = 1;
+    while ((1u << bits) < extended.size() * 2) ++bits;
+
+    uint32_t mult = 0x9E3779B1u;  // golden ratio, stepped through odd values on collision
+    for (;;) {
+        for (int attempt = 0; attempt < 1000; ++attempt, mult += 0x6A09E668u) {
+            uint32_t shift = 32 - bits;
+            std::vector<uint32_t> keys(1u << bits, 0);
+            std::vector<FrameSlot> slots(1u << bits, FrameSlot{0, 0, 0, 0, 0});
+            bool collision = false;
+
+            for (const auto& [can_id, slot] : extended) {
+                uint32_t idx = ((mult | 1u) * can_id) >> shift;
+                if (keys[idx] != 0) {
+                    collision = true;
+                    break;
+                }
+                keys[idx] = can_id;
+                slots[idx] = slot;
+            }
+
+            if (!collision) {
+                ext_keys_  = std::move(keys);
+                ext_slots_ = std::move(slots);
+                ext_mult_  = mult | 1u;
+                ext_shift_ = shift;
+                return;
+            }
+        }
+        ++bits;
+    }
+}
@@ -0,0 +1,168 @@
+#ifndef FSAE_FRAME_DECODER_HPP
+#define FSAE_FRAME_DECODER_HPP
+
+#include <linux/can.h>
+#include <cstdint>
+#include <vector>
+
+#include "config_types.hpp"
+#include "frame_parser.hpp"
+
+struct DecodeEntry;
+
+// extractor specialized at compile time for one value type and byte order
+using ExtractFn = double (*)(const FrameWords& words, const DecodeEntry& entry);
+
+struct DecodeEntry {
+    ExtractFn extract;
+    BitPlan plan;
+    double scale;
+    double offset;
+    uint32_t channel;   // index into FrameDecoder::channel()
+    uint16_t signal_id;
+};
+
+// entries sharing one 8-byte payload window, decoded from a single load
+struct WindowRun {
+    uint8_t base;
+    uint32_t count;
+};
+
+// contiguous runs of entries and windows belonging to one CAN ID, or to one mux page
+struct FrameSlot {
+    uint32_t begin;
+    uint32_t count;
+    uint32_t window_begin;
+    uint32_t window_count;
+    uint32_t mux;           // 1 + index into the mux tables, 0 if the frame is not multiplexed
+};
+
+// page table of a multiplexed frame: the multiplexor's raw value indexes pages directly
+struct MuxTable {
+    BitPlan plan;
+    ByteOrder order;
+    uint32_t page_begin;    // into FrameDecoder::pages_
+    uint32_t page_count;    // highest configured mux value + 1; empty pages have count 0
+};
+
+// FrameMap compiled into flat lookup tables, built once per config load
+// standard IDs index a 2048-entry table directly, extended IDs go through a perfect hash
+class FrameDecoder {
+public:
+    FrameDecoder() = default;
+
+    // throws std::invalid_argument for invalid IDs or signals that do not fit in the frame
+    explicit FrameDecoder(const FrameMap& frames);
+
+    // decode every configured signal in the frame, calling sink(entry, value)
+    // signals come out grouped by payload window, not in channel order (see DecodeEntry::channel)
+    // multiplexed frames decode their unconditional signals, then only the page the multiplexor selects
+    // signals past the end of a short CAN FD payload are skipped
+    // returns the number of signals decoded (0 for unknown IDs)
+    template <typename Sink>
+    uint32_t decode(const can_frame& frame, Sink&& sink) const {
+        return decode_data(frame.can_id, frame.data, CAN_MAX_DLEN, frame.can_dlc, sink);
+    }
+
+    template <typename Sink>
+    uint32_t decode(const canfd_frame& frame, Sink&& sink) const {
+        return decode_data(frame.can_id, frame.data, CANFD_MAX_DLEN, frame.len, sink);
+    }
+
+    const ChannelConfig& channel(uint32_t index) const { return channels_[index]; }
+
+    std::size_t channel_count() const { return channels_.size(); }
+
+private:
+    FrameSlot find(canid_t can_id) const;
+
+    // data holds capacity readable bytes, len of them received
+    template <typename Sink>
+    uint32_t decode_data(canid_t can_id, const uint8_t* data, uint32_t capacity, uint32_t len, Sink& sink) const;
+
+    // decode one run of entries; limit is the last payload byte a signal may end at
+    template <typename Sink>
+    uint32_t decode_run(const FrameSlot& run, const uint8_t* data, uint32_t capacity, uint32_t limit,
+                        Sink& sink) const;
+
+    void add_frame(const std::vector<ChannelConfig>& channels, FrameSlot& slot);
+
+    // append entries for channels_[index] of each index, grouped by window
+    FrameSlot add_run(const std::vector<uint32_t>& indices);
+
+    void build_extended_hash(const std::vector<std::pair<uint32_t, FrameSlot>>& extended);
+
+    std::vector<DecodeEntry> entries_;
+    std::vector<WindowRun> windows_;
+    std::vector<MuxTable> muxes_;
+    std::vector<FrameSlot> pages_;
+    std::vector<ChannelConfig> channels_;
+
+    std::vector<FrameSlot> standard_;
+
+    // extended IDs: slot = (id * ext_mult_) >> ext_shift_, verified against ext_keys_
+    std::vector<uint32_t> ext_keys_;
+    std::vector<FrameSlot> ext_slots_;
+    uint32_t ext_mult_ = 0;
+    uint32_t ext_shift_ = 32;
+};
+
+inline FrameSlot FrameDecoder::find(canid_t can_id) const {
+    if (can_id <= CAN_SFF_MASK) return standard_[can_id];
+
+    // remote and error frames carry no signal data
+    if ((can_id & (CAN_EFF_FLAG | CAN_RTR_FLAG | CAN_ERR_FLAG)) != CAN_EFF_FLAG || ext_keys_.empty()) {
+        return FrameSlot{0, 0, 0, 0, 0};
+    }
+    uint32_t idx = (can_id * ext_mult_) >> ext_shift_;
+    if (ext_keys_[idx] != can_id) return FrameSlot{0, 0, 0, 0, 0};
+    return ext_slots_[idx];
+}
+
+template <typename Sink>
+uint32_t FrameDecoder::decode_data(canid_t can_id, const uint8_t* data, uint32_t capacity, uint32_t len,
+                                   Sink& sink) const {
+    if (standard_.empty()) return 0;
+
+    FrameSlot slot = find(can_id);
+    if (slot.count == 0) return 0;
+
+    // classic frames always decode all 8 bytes, as before; FD payloads stop at len
+    uint32_t limit = len < CAN_MAX_DLEN ? CAN_MAX_DLEN : len;
+    if (limit > capacity) limit = capacity;
+
+    uint32_t decoded = decode_run(slot, data, capacity, limit, sink);
+    if (slot.mux == 0) return decoded;
+
+    // read the selector once and jump to its page; unconfigured values decode nothing more
+    const MuxTable& mux = muxes_[slot.mux - 1];
+    if (mux.plan.end > limit || mux.plan.base + 8u > capacity) return decoded;
+    uint64_t page = apply_bit_plan(load_frame_words(data + mux.plan.base), mux.order, mux.plan);
+    if (page >= mux.page_count) return decoded;
+    return decoded + decode_run(pages_[mux.page_begin + page], data, capacity, limit, sink);
+}
+
+template <typename Sink>
+uint32_t FrameDecoder::decode_run(const FrameSlot& run, const uint8_t* data, uint32_t capacity, uint32_t limit,
+                                  Sink& sink) const {
+    // one load per window, every signal is then a shift and mask of these words
+    // a 64-byte payload is at most 8 loads however many signals it carries
+    const DecodeEntry* e = entries_.data() + run.begin;
+    const WindowRun* w = windows_.data() + run.window_begin;
+    uint32_t decoded = 0;
+    for (uint32_t n = 0; n < run.window_count; ++n, ++w) {
+        if (w->base + 8u > capacity) {
+            e += w->count;
+            continue;
+        }
+        FrameWords words = load_frame_words(data + w->base);
+        for (uint32_t i = 0; i < w->count; ++i, ++e) {
+            if (e->plan.end > limit) continue;
+            sink(*e, e->extract(words, *e));
+            ++decoded;
+        }
+    }
+    return decoded;
+}
+
+#endif
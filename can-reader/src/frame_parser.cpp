@@ -1,23 +1,68 @@
 #include "frame_parser.hpp"
 
+#include <stdexcept>
+#include <string>
 
-template<typename T>
-static double extract(const can_frame& frame, const ChannelConfig& cfg) {
-    T raw_value = 0;
-    memcpy(&raw_value, &frame.data[cfg.start_byte], sizeof(T));
-    return raw_value * cfg.scale + cfg.offset;
+// prefer the aligned window holding first..last, else start the window at the first byte
+static int pick_window(int first, int last, int payload) {
+    int base = first / 8 * 8;
+    if (last >= base + 8) base = first;
+    return base + 8 > payload ? payload - 8 : base;
 }
 
-double parse_value(const can_frame& frame, const ChannelConfig& cfg) {
+BitPlan make_bit_plan(const ChannelConfig& cfg) {
+    int length = cfg.bit_length;
+    int payload = cfg.frame_bytes < 8 ? 8 : cfg.frame_bytes;
+    int first, last, base, shift;
+
+    if (cfg.byte_order == ByteOrder::INTEL) {
+        // start bit is the LSB, counted from bit 0 of byte 0
+        first = cfg.start_bit / 8;
+        last = (cfg.start_bit + length - 1) / 8;
+        base = pick_window(first, last, payload);
+        shift = cfg.start_bit - 8 * base;
+    } else {
+        // start bit is the MSB and the signal runs on into later bytes
+        // in the byte-swapped window word, byte b bit k sits at 56 - 8 * (b - base) + k
+        first = cfg.start_bit / 8;
+        last = (8 * first + (7 - cfg.start_bit % 8) + length - 1) / 8;
+        base = pick_window(first, last, payload);
+        int msb = 56 - 8 * (first - base) + cfg.start_bit % 8;
+        shift = msb - (length - 1);
+    }
+
+    if (length < 1 || length > 64 || last >= payload || base < 0 || shift < 0 || shift + length > 64) {
+        throw std::invalid_argument("signal '" + cfg.name + "' does not fit in the frame");
+    }
+
+    BitPlan plan;
+    plan.base  = static_cast<uint8_t>(base);
+    plan.end   = static_cast<uint8_t>(last + 1);
+    plan.shift = static_cast<uint8_t>(shift);
+    plan.mask  = length == 64 ? ~0ull : (1ull << length) - 1;
+    plan.sign  = cfg.type == SignalType::SIGNED ? 1ull << (length - 1) : 0;
+    return plan;
+}
+
+double parse_value(const uint8_t* data, const ChannelConfig& cfg) {
+    BitPlan plan = make_bit_plan(cfg);
+    FrameWords words = load_frame_words(data + plan.base);
+    uint64_t raw = apply_bit_plan(words, cfg.byte_order, plan);
+
     switch (cfg.type) {
-        case SignalType::UINT8:     return extract<uint8_t>(frame, cfg);
-        case SignalType::INT8:      return extract<int8_t>(frame, cfg);
-        case SignalType::UINT16:    return extract<uint16_t>(frame, cfg);
-        case SignalType::INT16:     return extract<int16_t>(frame, cfg);
-        case SignalType::UINT32:    return extract<uint32_t>(frame, cfg);
-        case SignalType::INT32:     return extract<int32_t>(frame, cfg);
-        case SignalType::FLOAT:     return extract<float>(frame, cfg);
-        case SignalType::DOUBLE:    return extract<double>(frame, cfg);
+        case SignalType::UNSIGNED:  return static_cast<double>(raw) * cfg.scale + cfg.offset;
+        case SignalType::SIGNED:    return static_cast<double>(static_cast<int64_t>(raw)) * cfg.scale + cfg.offset;
+        case SignalType::FLOAT: {
+            uint32_t bits = static_cast<uint32_t>(raw);
+            float f;
+            memcpy(&f, &bits, sizeof(f));
+            return f * cfg.scale + cfg.offset;
+        }
+        case SignalType::DOUBLE: {
+            double d;
+            memcpy(&d, &raw, sizeof(d));
+            return d * cfg.scale + cfg.offset;
+        }
     }
     return 0.0;
 }
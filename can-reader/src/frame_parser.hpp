@@ -2,10 +2,58 @@
 #define FSAE_FRAME_PARSER_HPP
 
 #include <linux/can.h>
+#include <endian.h>
+#include <cstdint>
+#include <cstring>
 
 #include "config_types.hpp"
 
-// parse a raw CAN frame into a TelemetryMessage using channel config
-double parse_value(const can_frame& frame, const ChannelConfig& cfg);
+// 8 data bytes starting at a window base, loaded once as a little-endian and a big-endian 64-bit word
+// classic frames are a single window at byte 0; CAN FD payloads are covered by several
+struct FrameWords {
+    uint64_t intel;
+    uint64_t motorola;
+};
+
+inline FrameWords load_frame_words(const uint8_t* data) {
+    uint64_t raw;
+    memcpy(&raw, data, sizeof(raw));
+    uint64_t le = le64toh(raw);
+    return FrameWords{le, __builtin_bswap64(le)};
+}
+
+// shift/mask recipe that pulls one signal's raw bits out of the matching word of its window
+struct BitPlan {
+    uint8_t base;       // byte offset of the 8-byte window holding the signal
+    uint8_t end;        // one past the last payload byte the signal touches
+    uint8_t shift;
+    uint64_t mask;
+    uint64_t sign;      // sign bit for SIGNED signals, 0 otherwise
+};
+
+// windows are 8-byte aligned where the signal fits in one, so signals packed into a
+// 64-byte payload share at most 8 loads; only signals straddling a boundary get their own
+// throws std::invalid_argument if the signal does not fit in cfg.frame_bytes
+BitPlan make_bit_plan(const ChannelConfig& cfg);
+
+// raw bits of a signal, sign-extended for SIGNED plans (sign == 0 leaves the value as is)
+inline uint64_t apply_bit_plan(const FrameWords& words, ByteOrder order, const BitPlan& plan) {
+    uint64_t word = order == ByteOrder::INTEL ? words.intel : words.motorola;
+    uint64_t raw = (word >> plan.shift) & plan.mask;
+    return (raw ^ plan.sign) - plan.sign;
+}
+
+// decode one signal from payload bytes using channel config
+// data must hold at least max(cfg.frame_bytes, 8) bytes
+double parse_value(const uint8_t* data, const ChannelConfig& cfg);
+
+// decode one signal from a raw CAN frame; the config must describe a classic (<= 8 byte) message
+inline double parse_value(const can_frame& frame, const ChannelConfig& cfg) {
+    return parse_value(frame.data, cfg);
+}
+
+inline double parse_value(const canfd_frame& frame, const ChannelConfig& cfg) {
+    return parse_value(frame.data, cfg);
+}
 
 #endif
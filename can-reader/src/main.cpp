@@ -1,79 +1,300 @@
+#include <cerrno>
 #include <csignal>
 #include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unistd.h>
+#include <vector>
 
 #include "config_types.hpp"
+#include "config_parser.hpp"
 #include "dbc_parser.hpp"
 #include "shared_memory.hpp"
-#include "can_socket.hpp"
-#include "frame_parser.hpp"
+#include "latency_histogram.hpp"
+#include "event_loop.hpp"
+#include "bus_reader.hpp"
+#include "telemetry_publisher.hpp"
+#include "derived_channels.hpp"
+#include "backpressure.hpp"
 
-static volatile sig_atomic_t running = 1;
-static volatile sig_atomic_t reload_flag = 0;
+static void print_socket_stats(const BusReader& bus) {
+    CanSocketStats st = bus.socket_stats();
+    printf("%s: %llu delivered, %llu rejected by filter, %llu overflowed\n", bus.config().interface.c_str(),
+           static_cast<unsigned long long>(st.delivered),
+           static_cast<unsigned long long>(st.rejected),
+           static_cast<unsigned long long>(st.overflowed));
+    const BusStats& stats = bus.stats();
+    uint64_t swaps = stats.config_swaps.load(std::memory_order_relaxed);
+    if (swaps)
+        printf("%s: %llu config swaps, last switched %.1f us after publish (compiled in %.2f ms)\n",
+               bus.config().interface.c_str(), static_cast<unsigned long long>(swaps),
+               stats.swap_latency_ns.load(std::memory_order_relaxed) / 1e3,
+               stats.compile_ns.load(std::memory_order_relaxed) / 1e6);
+    static const char* const mode_names[PUBLISH_MODES] = {"always", "on_change", "deadband", "rate"};
+    for (int m = 0; m < PUBLISH_MODES; ++m) {
+        uint64_t saved = stats.suppressed[m].load(std::memory_order_relaxed);
+        if (saved)
+            printf("%s: %llu pushes saved by %s policies\n", bus.config().interface.c_str(),
+                   static_cast<unsigned long long>(saved), mode_names[m]);
+    }
+    if (bus.trace_drops())
+        printf("%s: %llu trace records dropped\n", bus.config().interface.c_str(),
+               static_cast<unsigned long long>(bus.trace_drops()));
+}
+
+// attach each signal's publish policy; names in the config that match no signal are reported
+static void apply_publish_policies(std::vector<FrameMap>& frame_maps, const CanReaderConfig& cfg) {
+    std::unordered_map<std::string, bool> used;
+    for (const auto& [name, policy] : cfg.publish) used[name] = false;
 
-static void signal_handler(int sig) {
-    if (sig == SIGINT || sig == SIGTERM) running = 0;
-    if (sig == SIGHUP) reload_flag = 1;
+    for (auto& frames : frame_maps) {
+        for (auto& [can_id, channels] : frames) {
+            for (auto& channel : channels) {
+                auto it = cfg.publish.find(channel.name);
+                channel.publish = it == cfg.publish.end() ? cfg.default_publish : it->second;
+                if (it != cfg.publish.end()) used[channel.name] = true;
+            }
+        }
+    }
+    for (const auto& [name, found] : used) {
+        if (!found) std::fprintf(stderr, "Publish policy for unknown signal '%s'\n", name.c_str());
+    }
+}
+
+// load every bus's DBC and give its signals IDs and publish policies; false if any bus has no usable config,
+// leaving frame_maps as it was
+static bool load_bus_configs(const CanReaderConfig& cfg, SignalTable& signals,
+                             std::vector<FrameMap>& frame_maps) {
+    const std::vector<BusConfig>& buses = cfg.buses;
+    std::vector<FrameMap> loaded;
+    for (const auto& bus : buses) {
+        FrameMap frames;
+        try {
+            frames = load_dbc_config(bus.dbc_path);
+        } catch (const std::exception& e) {
+            std::fprintf(stderr, "%s: bad CAN config %s: %s\n", bus.interface.c_str(), bus.dbc_path.c_str(), e.what());
+            return false;
+        }
+        if (frames.empty()) {
+            std::fprintf(stderr, "%s: failed to load CAN config %s\n", bus.interface.c_str(), bus.dbc_path.c_str());
+            return false;
+        }
+        // existing signals keep their IDs, new ones are appended
+        if (!intern_signals(frames, signals)) {
+            std::fprintf(stderr, "Signal table full, some signals will not be published\n");
+        }
+        loaded.push_back(std::move(frames));
+    }
+    apply_publish_policies(loaded, cfg);
+    frame_maps = std::move(loaded);
+    return true;
+}
+
+// compile the derived channels against the loaded signals; nullptr if none are configured
+// throws std::invalid_argument like DerivedEngine
+static std::unique_ptr<DerivedEngine> build_derived(const CanReaderConfig& cfg,
+                                                    const std::vector<FrameMap>& frame_maps, SignalTable& signals) {
+    if (cfg.derived.empty()) return nullptr;
+    auto derived = std::make_unique<DerivedEngine>(cfg.derived, frame_maps, signals);
+    printf("%zu derived channels, %zu instructions\n", derived->channel_count(), derived->instruction_count());
+    return derived;
+}
+
+// mark the signals backpressure.low_priority names, decoded or derived, by signal ID
+static std::vector<uint8_t> build_low_priority(const CanReaderConfig& cfg, const std::vector<FrameMap>& frame_maps,
+                                               const SignalTable& signals) {
+    std::vector<uint8_t> low_priority(MAX_SIGNALS, 0);
+    for (const auto& name : cfg.backpressure.low_priority) {
+        bool found = false;
+        for (const auto& frames : frame_maps) {
+            for (const auto& [can_id, channels] : frames) {
+                for (const auto& channel : channels) {
+                    if (channel.name != name || channel.signal_id >= MAX_SIGNALS) continue;
+                    low_priority[channel.signal_id] = 1;
+                    found = true;
+                }
+            }
+        }
+        uint16_t derived = signals.find(DERIVED_CAN_ID, name);
+        if (derived < MAX_SIGNALS) {
+            low_priority[derived] = 1;
+            found = true;
+        }
+        if (!found) std::fprintf(stderr, "Low-priority signal '%s' is not defined\n", name.c_str());
+    }
+    return low_priority;
 }
 
 int main() {
 
-    struct sigaction sa{};
-    sa.sa_handler = signal_handler;
-    sigaction(SIGINT, &sa, nullptr);
-    sigaction(SIGTERM, &sa, nullptr);
-    sa.sa_handler = signal_handler;
-    sigaction(SIGHUP, &sa, nullptr);
+    // SIGHUP/SIGTERM/SIGINT arrive through the event loop; set up before any thread starts
+    EventLoop loop;
+    std::function<void()> reload;
+    if (!loop.ok() || !loop.add_signals({SIGINT, SIGTERM, SIGHUP}, [&](int signo) {
+            if (signo == SIGHUP) reload();
+            else loop.stop();
+        })) {
+        std::perror("Failed to set up event loop");
+        return 1;
+    }
 
-    FrameMap frame_map = load_dbc_config(DEFAULT_DBC_PATH);
-    if(frame_map.empty()) {
-        std::fprintf(stderr, "Failed to load CAN config\n");
+    CanReaderConfig reader_cfg;
+    try {
+        reader_cfg = load_reader_config(DEFAULT_READER_CONFIG_PATH);
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "Bad reader config %s: %s\n", DEFAULT_READER_CONFIG_PATH, e.what());
         return 1;
     }
 
-    TelemetryQueue* queue = open_shared_queue(true);
-    if (!queue) {
-        std::perror("Failed to open shared memory queue");
+    SignalTable* signals = open_signal_table(true);
+    if (!signals) {
+        std::perror("Failed to open shared memory signal table");
+        return 1;
+    }
+
+    std::vector<FrameMap> frame_maps;
+    if (!load_bus_configs(reader_cfg, *signals, frame_maps)) {
+        close_signal_table(signals, true);
         return 1;
     }
 
-    CanSocket sock;
-    if( !sock.open("vcan0")) {
-        std::perror("Failed to open CAN socket");
-        close_shared_queue(queue, true);
+    std::unique_ptr<DerivedEngine> derived;
+    try {
+        derived = build_derived(reader_cfg, frame_maps, *signals);
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "Bad reader config %s: %s\n", DEFAULT_READER_CONFIG_PATH, e.what());
+        close_signal_table(signals, true);
         return 1;
     }
 
-    can_frame frame;
-    while(running) {
-        if (sock.read(frame)) {
+    TelemetryQueue* queue = open_shared_queue(true, reader_cfg.queue);
+    if (!queue) {
+        std::perror("Failed to open shared memory queue");
+        close_signal_table(signals, true);
+        return 1;
+    }
+
+    // metrics are best effort: without the segment they go to a private copy
+    static StatsSegment local_stats;
+    StatsSegment* shared_stats = open_stats_segment();
+    if (!shared_stats) std::perror("Failed to open stats segment");
+    ReaderStats& stats = shared_stats ? shared_stats->reader : local_stats.reader;
+    stats.pid.store(static_cast<int32_t>(getpid()), std::memory_order_relaxed);
+    stats.rx_to_queue.reset();
+
+    TelemetryPublisher publisher(*queue, *signals, stats);
+    publisher.set_derived(std::move(derived));
+    publisher.set_low_priority(build_low_priority(reader_cfg, frame_maps, *signals));
 
-            printf("Received CAN frame with ID: %03x\n", frame.can_id);
-            auto it = frame_map.find(frame.can_id);
-            if (it == frame_map.end()) {
-                continue;
+    // the spill ring sits next to the queue for a lossless consumer to fall back on
+    SpillRing* spill = nullptr;
+    if (reader_cfg.backpressure.spill_capacity && !shared_stats) {
+        std::fprintf(stderr, "Spilling needs the stats segment to find consumers; disabled\n");
+    } else if (reader_cfg.backpressure.spill_capacity && queue->multi_producer()) {
+        std::fprintf(stderr, "Spilling needs can-reader to be the queue's only producer; disabled\n");
+    } else if (reader_cfg.backpressure.spill_capacity) {
+        spill = open_spill_ring(true, reader_cfg.backpressure.spill_capacity);
+        if (!spill) std::perror("Failed to open spill ring");
+    }
+    BackpressureMonitor backpressure(publisher, shared_stats ? *shared_stats : local_stats, queue->capacity(), spill,
+                                     reader_cfg.backpressure);
+
+    // one thread per interface, all merging into the same ring
+    std::vector<std::unique_ptr<BusReader>> buses;
+    bool started = true;
+    for (std::size_t i = 0; i < reader_cfg.buses.size() && started; ++i) {
+        const BusConfig& cfg = reader_cfg.buses[i];
+        auto bus = std::make_unique<BusReader>(cfg, publisher, *signals, stats.buses[i]);
+        try {
+            if (!bus->open(frame_maps[i])) {
+                std::fprintf(stderr, "Failed to open CAN socket %s: %s\n", cfg.interface.c_str(), strerror(errno));
+                started = false;
+            } else if (!bus->start(reader_cfg.trace)) {
+                std::fprintf(stderr, "Failed to start reader thread for %s\n", cfg.interface.c_str());
+                started = false;
             }
+        } catch (const std::exception& e) {
+            std::fprintf(stderr, "%s: %s\n", cfg.interface.c_str(), e.what());
+            started = false;
+        }
+        buses.push_back(std::move(bus));
+    }
+
+    reload = [&]() {
+        // the trace level, publish policies, derived channels, backpressure thresholds and DBCs
+        // apply without a restart; the queue, the spill ring, the check period and the bus list are fixed
+        try {
+            CanReaderConfig fresh = load_reader_config(DEFAULT_READER_CONFIG_PATH);
+            for (auto& bus : buses) bus->set_trace_level(fresh.trace);
+            reader_cfg.default_publish = fresh.default_publish;
+            reader_cfg.publish = std::move(fresh.publish);
+            reader_cfg.derived = std::move(fresh.derived);
+            reader_cfg.backpressure.low_priority = fresh.backpressure.low_priority;
+            backpressure.set_config(fresh.backpressure);
+        } catch (const std::exception& e) {
+            std::fprintf(stderr, "Bad reader config %s: %s\n", DEFAULT_READER_CONFIG_PATH, e.what());
+        }
 
-            const auto& channels = it->second;
-
-            for (const auto& cfg : channels) {
-                // build telemetry message
-                TelemetryMessage msg;
-                msg.can_id = frame.can_id;
-                std::strncpy(msg.signal_name, cfg.name.c_str(), sizeof(msg.signal_name) - 1);
-                msg.signal_name[sizeof(msg.signal_name) - 1] = '\0';
-                msg.value = parse_value(frame, cfg);
-                queue->push(msg);
-                printf("Parsed signal '%s' for CAN ID %03x: %f\n", msg.signal_name, frame.can_id, msg.value);
+        // DBC parsing and decoder builds happen here; bus threads keep decoding the old config
+        uint64_t start = monotonic_ns();
+        if (!load_bus_configs(reader_cfg, *signals, frame_maps)) {
+            std::fprintf(stderr, "Keeping the previous CAN config\n");
+            return;
+        }
+        for (std::size_t i = 0; i < buses.size(); ++i) {
+            try {
+                buses[i]->reload(frame_maps[i]);
+            } catch (const std::exception& e) {
+                std::fprintf(stderr, "%s: keeping the previous CAN config: %s\n",
+                             buses[i]->config().interface.c_str(), e.what());
             }
         }
-        if (reload_flag) {
-            reload_flag = 0;
-            frame_map = load_dbc_config(DEFAULT_DBC_PATH);
-            printf("Reloaded config\n");
+        try {
+            publisher.set_derived(build_derived(reader_cfg, frame_maps, *signals));
+        } catch (const std::exception& e) {
+            std::fprintf(stderr, "Keeping the previous derived channels: %s\n", e.what());
+        }
+        publisher.set_low_priority(build_low_priority(reader_cfg, frame_maps, *signals));
+        printf("Reloaded config in %.2f ms\n", (monotonic_ns() - start) / 1e6);
+        print_latency("rx->queue", stats.rx_to_queue);
+    };
+
+    // bus threads keep their own heartbeats; this one says the process is alive
+    auto on_tick = [&]() {
+        stat_set(stats.heartbeat_ns, monotonic_ns());
+        for (auto& bus : buses) bus->reclaim();
+    };
+
+    if (started) {
+        if (!loop.add_timer(std::chrono::seconds(1), on_tick) ||
+            !loop.add_timer(std::chrono::nanoseconds(reader_cfg.backpressure.check_ns),
+                            [&]() { backpressure.check(queue->current_pos(), monotonic_ns()); })) {
+            std::perror("Failed to register with event loop");
+        } else if (!loop.run()) {
+            std::perror("Event loop failed");
         }
     }
 
+    for (auto& bus : buses) bus->stop();
+    for (auto& bus : buses) print_socket_stats(*bus);
+    print_latency("rx->queue", stats.rx_to_queue);
+    uint64_t decimated = stats.decimated.load(std::memory_order_relaxed);
+    uint64_t spill_full = stats.spill_full.load(std::memory_order_relaxed);
+    if (decimated) printf("%llu low-priority values decimated\n", static_cast<unsigned long long>(decimated));
+    if (spill_full) printf("%llu items lost with the spill ring full\n", static_cast<unsigned long long>(spill_full));
+    buses.clear();
+
+    stats.pid.store(0, std::memory_order_relaxed);
+    if (shared_stats) close_stats_segment(shared_stats);
+    publisher.set_spill(nullptr, nullptr);
+    if (spill) close_spill_ring(spill, true);
     close_shared_queue(queue, true);
+    close_signal_table(signals, true);
 
-    return 0;
+    return started ? 0 : 1;
 }
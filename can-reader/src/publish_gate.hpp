@@ -0,0 +1,37 @@
+#ifndef FSAE_PUBLISH_GATE_HPP
+#define FSAE_PUBLISH_GATE_HPP
+
+#include <cstdint>
+
+#include "config_types.hpp"
+
+// per-signal publish state, checked in the decode loop before a value is staged
+struct PublishGate {
+    PublishPolicy policy;
+    double last_value = 0.0;
+    uint64_t last_ns = 0;       // CLOCK_MONOTONIC of the last publish, 0 = never published
+
+    // true if value should go out now; records it as published if so
+    bool admit(double value, uint64_t now_ns) {
+        if (policy.mode == PublishMode::ALWAYS) return true;
+
+        bool due = last_ns == 0;
+        uint64_t elapsed = now_ns - last_ns;
+        switch (policy.mode) {
+            case PublishMode::ALWAYS:       break;
+            // NaN never compares equal, so a NaN value is always published
+            case PublishMode::ON_CHANGE:    due |= !(value == last_value); break;
+            case PublishMode::DEADBAND:     due |= !(value - last_value <= policy.deadband &&
+                                                     last_value - value <= policy.deadband); break;
+            case PublishMode::RATE:         due |= elapsed >= policy.min_interval_ns; break;
+        }
+        if (policy.heartbeat_ns != 0 && elapsed >= policy.heartbeat_ns) due = true;
+        if (!due) return false;
+
+        last_value = value;
+        last_ns = now_ns;
+        return true;
+    }
+};
+
+#endif
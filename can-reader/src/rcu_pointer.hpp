@@ -0,0 +1,101 @@
+#ifndef FSAE_RCU_POINTER_HPP
+#define FSAE_RCU_POINTER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// pointer to an immutable object, replaced by one writer while a fixed set of reader threads use it
+// readers bracket each use with enter()/exit() and never block or wait; the writer swaps in a new
+// object and frees old ones only once every reader has been outside a read section since the swap
+// each published object gets a generation number: a freed object's address may come back for a
+// later one, so readers that need to notice a swap compare generations, never pointers
+template <typename T>
+class RcuPointer {
+public:
+    explicit RcuPointer(int readers) : reader_epochs_(readers) {
+        for (auto& e : reader_epochs_) e.value.store(0, std::memory_order_relaxed);
+    }
+
+    ~RcuPointer() {
+        delete current_.load(std::memory_order_relaxed);
+        for (auto& r : retired_) delete r.node;
+    }
+
+    RcuPointer(const RcuPointer&) = delete;
+    RcuPointer& operator=(const RcuPointer&) = delete;
+
+    // reader side: the returned object stays valid until exit(reader)
+    const T* enter(int reader) {
+        uint64_t generation;
+        return enter(reader, generation);
+    }
+
+    // as above, also returning the object's generation (0 for none published yet)
+    const T* enter(int reader, uint64_t& generation) {
+        reader_epochs_[reader].value.store(epoch_.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+        const Node* node = current_.load(std::memory_order_seq_cst);
+        generation = node ? node->generation : 0;
+        return node ? node->object.get() : nullptr;
+    }
+
+    void exit(int reader) {
+        reader_epochs_[reader].value.store(0, std::memory_order_release);
+    }
+
+    // writer side: install next; the previous object is retired, not freed
+    void publish(std::unique_ptr<T> next) {
+        const Node* node = next ? new Node{std::move(next), ++generation_} : nullptr;
+        const Node* old = current_.exchange(node, std::memory_order_seq_cst);
+        uint64_t epoch = epoch_.fetch_add(1, std::memory_order_seq_cst) + 1;
+        if (old) retired_.push_back(Retired{old, epoch});
+    }
+
+    // writer side: free retired objects no reader can still be using; returns how many are left
+    std::size_t reclaim() {
+        std::size_t kept = 0;
+        for (auto& r : retired_) {
+            if (!quiescent_since(r.epoch)) {
+                retired_[kept++] = r;
+                continue;
+            }
+            delete r.node;
+        }
+        retired_.resize(kept);
+        return kept;
+    }
+
+private:
+    // the object and its generation, swapped as one pointer so readers never see them mismatched
+    struct Node {
+        std::unique_ptr<T> object;
+        uint64_t generation;
+    };
+
+    struct Retired {
+        const Node* node;
+        uint64_t epoch;     // readers that entered at this epoch or later see the replacement
+    };
+
+    // every reader is either outside a read section or entered after the swap
+    bool quiescent_since(uint64_t epoch) const {
+        for (const auto& e : reader_epochs_) {
+            uint64_t seen = e.value.load(std::memory_order_seq_cst);
+            if (seen != 0 && seen < epoch) return false;
+        }
+        return true;
+    }
+
+    struct alignas(64) ReaderEpoch {
+        std::atomic<uint64_t> value;    // epoch at enter(), 0 while outside a read section
+    };
+
+    std::atomic<const Node*> current_{nullptr};
+    uint64_t generation_ = 0;           // writer only
+    std::atomic<uint64_t> epoch_{1};
+    std::vector<ReaderEpoch> reader_epochs_;
+    std::vector<Retired> retired_;      // writer only
+};
+
+#endif
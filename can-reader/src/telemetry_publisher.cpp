@@ -0,0 +1,88 @@
+#include "telemetry_publisher.hpp"
+
+void TelemetryPublisher::publish(const TelemetryMessage* msgs, const uint64_t* wall_ns, std::size_t count,
+                                 const uint8_t* queued) {
+    if (count == 0) return;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        // the target reports its position once per batch it takes, so one look per publish is enough
+        if (spill_target_) {
+            std::size_t reached = spill_target_->position.load(std::memory_order_acquire);
+            if (reached > spill_floor_) spill_floor_ = reached;
+        }
+
+        uint64_t held = 0;
+        uint64_t queued_ns = monotonic_ns();
+        for (std::size_t i = 0; i < count; ++i) {
+            if (queued && !queued[i]) {
+                // held back by its publish policy
+            } else if (decimated(msgs[i].signal_id)) {
+                ++held;
+            } else {
+                push(msgs[i], queued_ns);
+            }
+            signals_.update(msgs[i].signal_id, msgs[i].value, wall_ns[i]);
+        }
+        if (derived_) {
+            derived_msgs_.clear();
+            derived_wall_.clear();
+            derived_->update(msgs, wall_ns, count);
+            derived_->evaluate(derived_msgs_, derived_wall_);
+            for (std::size_t i = 0; i < derived_msgs_.size(); ++i) {
+                if (decimated(derived_msgs_[i].signal_id)) ++held;
+                else push(derived_msgs_[i], queued_ns);
+                signals_.update(derived_msgs_[i].signal_id, derived_msgs_[i].value, derived_wall_[i]);
+            }
+        }
+        if (held) stat_add(stats_.decimated, held);
+        stat_set(stats_.queue_write_idx, queue_.current_pos());
+    }
+
+    // histogram buckets are atomic, no need to hold up the other buses for this
+    uint64_t now = monotonic_ns();
+    for (std::size_t i = 0; i < count; ++i) {
+        if (!queued || queued[i]) stats_.rx_to_queue.record_since(msgs[i].ingest_ns, now);
+    }
+}
+
+std::unique_ptr<DerivedEngine> TelemetryPublisher::set_derived(std::unique_ptr<DerivedEngine> derived) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    derived_.swap(derived);
+    return derived;
+}
+
+void TelemetryPublisher::set_low_priority(std::vector<uint8_t> low_priority) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    low_priority_ = std::move(low_priority);
+    decimate_count_.assign(low_priority_.size(), 0);
+}
+
+void TelemetryPublisher::set_decimation(uint32_t keep) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    decimate_keep_ = keep;
+}
+
+void TelemetryPublisher::set_spill(SpillRing* spill, ConsumerStats* target) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (target == spill_target_ && spill == spill_) return;
+    spill_ = spill;
+    spill_target_ = spill ? target : nullptr;
+    spill_floor_ = spill_target_ ? spill_target_->position.load(std::memory_order_acquire) : 0;
+}
+
+void TelemetryPublisher::spill_overwritten() {
+    // consumers treat the slot the next push writes as already gone (peek_batch starts one past
+    // it), so take that item now rather than the one this push overwrites; otherwise an idle
+    // producer would leave it out of both the queue and the spill ring
+    std::size_t next = queue_.current_pos() + 1;
+    std::size_t capacity = queue_.capacity();
+    if (next < capacity || next - capacity < spill_floor_) return;
+
+    SpillRecord record;
+    record.pos = next - capacity;
+    if (queue_.read(record.pos, record.msg) && spill_->push(record)) stat_add(spill_target_->spilled);
+    else stat_add(stats_.spill_full);
+    spill_floor_ = record.pos + 1;
+}
@@ -0,0 +1,84 @@
+#ifndef FSAE_TELEMETRY_PUBLISHER_HPP
+#define FSAE_TELEMETRY_PUBLISHER_HPP
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "derived_channels.hpp"
+#include "shared_memory.hpp"
+
+// the one path from the bus threads into the telemetry ring and the latest-value table
+// each call publishes a whole batch under one lock, so a bus's messages stay in order
+// and batches from different buses never interleave
+// derived channels are evaluated here too, since this is where every bus's values meet
+class TelemetryPublisher {
+public:
+    TelemetryPublisher(TelemetryQueue& queue, SignalTable& signals, ReaderStats& stats)
+        : queue_(queue), signals_(signals), stats_(stats) {}
+
+    TelemetryPublisher(const TelemetryPublisher&) = delete;
+    TelemetryPublisher& operator=(const TelemetryPublisher&) = delete;
+
+    // wall_ns[i] is the CLOCK_REALTIME receive time of msgs[i], for the latest-value table
+    // derived channels that changed inputs follow the batch, stamped with the newest input
+    // with `queued`, msgs[i] goes into the queue only if queued[i] != 0 (its publish policy let it
+    // through); the latest-value table and derived channels see every message either way
+    void publish(const TelemetryMessage* msgs, const uint64_t* wall_ns, std::size_t count,
+                 const uint8_t* queued = nullptr);
+
+    // swap in a new set of derived channels (nullptr for none); returns the old one
+    std::unique_ptr<DerivedEngine> set_derived(std::unique_ptr<DerivedEngine> derived);
+
+    // signals that may be decimated: low_priority[signal ID] != 0
+    void set_low_priority(std::vector<uint8_t> low_priority);
+
+    // push 1 in `keep` values of each low-priority signal (1 = all of them); the latest-value
+    // table and derived channels still see every value
+    void set_decimation(uint32_t keep);
+
+    // before pushing over an item `target` hasn't reported consuming, copy it to `spill`
+    // only correct while this publisher is the queue's only producer; nullptr target stops it
+    void set_spill(SpillRing* spill, ConsumerStats* target);
+
+private:
+    // stamped with the batch's push time, for consumers' queue_to_consume
+    void push(const TelemetryMessage& msg, uint64_t queued_ns) {
+        if (spill_target_) spill_overwritten();
+        TelemetryMessage stamped = msg;
+        uint64_t delay = queued_ns > msg.ingest_ns ? queued_ns - msg.ingest_ns : 0;
+        stamped.queue_delay_ns = delay > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(delay);
+        queue_.push(stamped);
+    }
+
+    // pushing moves the oldest readable item out of consumers' reach: keep it if the spill target
+    // still needs it
+    void spill_overwritten();
+
+    bool decimated(uint16_t signal_id) {
+        if (decimate_keep_ <= 1 || signal_id >= low_priority_.size() || !low_priority_[signal_id]) return false;
+        if (++decimate_count_[signal_id] < decimate_keep_) return true;
+        decimate_count_[signal_id] = 0;
+        return false;
+    }
+
+    std::mutex mutex_;
+    std::unique_ptr<DerivedEngine> derived_;
+
+    std::vector<uint8_t> low_priority_;
+    std::vector<uint32_t> decimate_count_;
+    uint32_t decimate_keep_ = 1;
+
+    SpillRing* spill_ = nullptr;
+    ConsumerStats* spill_target_ = nullptr;
+    std::size_t spill_floor_ = 0;   // lowest position still worth spilling
+
+    std::vector<TelemetryMessage> derived_msgs_;
+    std::vector<uint64_t> derived_wall_;
+    TelemetryQueue& queue_;
+    SignalTable& signals_;
+    ReaderStats& stats_;
+};
+
+#endif
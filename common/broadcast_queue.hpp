@@ -2,57 +2,334 @@
 #define FSAE_BROADCAST_QUEUE_HPP
 
 #include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
 #include <cstring>
+#include <ctime>
+#include <new>
+#include <type_traits>
 
-template <typename T, std::size_t Capacity = 4096>
-class BroadcastQueue {
-    static_assert((Capacity & (Capacity - 1)) == 0, "capacity must be a power of 2");
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// ring of `capacity` items sized at runtime; the sequence words and items live in the
+// same allocation, directly after the queue object (see bytes_for / create)
+// single-producer by default; a queue created multi-producer takes push() from any number
+// of threads or processes at once (see push for how)
+template <typename T>
+class alignas(64) BroadcastQueue {
+    static_assert(std::is_trivially_copyable_v<T>, "items are copied out under a seqlock");
 
 public:
-    BroadcastQueue() = default;
+    // up to two contiguous runs of items in ring order, split at the wrap point
+    struct Batch {
+        const T* first;
+        std::size_t first_len;
+        const T* second;
+        std::size_t second_len;
+        std::size_t begin;      // position of first[0]
+        std::size_t dropped;    // items skipped because the writer lapped the consumer
+
+        std::size_t size() const { return first_len + second_len; }
+    };
+
+    // bytes needed for a queue holding `capacity` items, including its trailing storage
+    static std::size_t bytes_for(std::size_t capacity);
+
+    // construct a queue in `memory`, which must be bytes_for(capacity) long and 64-byte aligned
+    // capacity must be a power of 2
+    static BroadcastQueue* create(void* memory, std::size_t capacity, bool multi_producer = false);
 
     BroadcastQueue(const BroadcastQueue&) = delete;
     BroadcastQueue& operator=(const BroadcastQueue&) = delete;
 
+    std::size_t capacity() const { return capacity_; }
+
+    bool multi_producer() const { return multi_producer_; }
+
     // push a new item — overwrites oldest if full
-    void push(const T& item);
+    // multi-producer queues reserve a position atomically and commit the slot, and the committed
+    // prefix is published in reservation order; a producer that stalls between the two holds
+    // back publication (not other producers' writes) until it commits
+    void push(const T& item) {
+        if (multi_producer_) push_mp(item);
+        else push_sp(item);
+    }
 
     // consume all new items since consumer_pos, calling callback on each
     // consumer_pos is updated to the current write position after consuming
+    // if the writer lapped the consumer, it skips ahead to the oldest intact item
+    // returns the number of items lost that way; torn items are never passed to callback
     template <typename Callback>
-    void consume(std::size_t& consumer_pos, Callback callback);
+    std::size_t consume(std::size_t& consumer_pos, Callback callback);
+
+    // zero-copy view of up to max_items new items since consumer_pos, pointing into the ring
+    // the writer keeps running, so the view is only trustworthy once commit() says so
+    Batch peek_batch(std::size_t consumer_pos, std::size_t max_items) const;
+
+    // finish a batch from peek_batch: consumer_pos moves past it
+    // returns how many items at the front of the batch were overwritten while held (0 = all intact)
+    std::size_t commit(std::size_t& consumer_pos, const Batch& batch) const;
 
     // get the current write index - call once to initialize a new consumer
     std::size_t current_pos() const;
 
+    // copy out item pos if its slot still holds it; false if it was (or is being) overwritten
+    bool read(std::size_t pos, T& out) const;
+
+    // block until there is something past consumer_pos, the timeout expires, or a signal arrives
+    // returns true if data is ready
+    bool wait_for_data(std::size_t consumer_pos, std::chrono::nanoseconds timeout);
+
 private:
-    T buffer_[Capacity];
-    std::atomic<std::size_t> write_idx_{0};
+    BroadcastQueue(std::size_t capacity, bool multi_producer)
+        : capacity_(capacity), mask_(capacity - 1), multi_producer_(multi_producer) {}
+
+    void push_sp(const T& item);
+
+    void push_mp(const T& item);
+
+    // wake consumers sleeping in wait_for_data, if there are any
+    void wake_waiters();
+
+    static constexpr std::size_t align_up(std::size_t n) { return (n + 63) & ~std::size_t{63}; }
+    static constexpr std::size_t seq_offset() { return align_up(sizeof(BroadcastQueue)); }
+    std::size_t buffer_offset() const { return seq_offset() + align_up(capacity_ * sizeof(std::atomic<std::size_t>)); }
+
+    // slot sequence: 2 * (pos + 1) once item pos is complete, odd while a write is in progress
+    std::atomic<std::size_t>* seq() const {
+        return reinterpret_cast<std::atomic<std::size_t>*>(reinterpret_cast<uintptr_t>(this) + seq_offset());
+    }
+    T* buffer() const {
+        return reinterpret_cast<T*>(reinterpret_cast<uintptr_t>(this) + buffer_offset());
+    }
+
+    const std::size_t capacity_;
+    const std::size_t mask_;
+    const bool multi_producer_;
+
+    // own cache line so pushes don't keep invalidating the read-mostly fields above
+    // everything below write_idx_ is committed and visible to consumers
+    alignas(64) std::atomic<std::size_t> write_idx_{0};
+
+    // multi-producer only: next position to hand out; write_idx_ <= reserve_idx_
+    alignas(64) std::atomic<std::size_t> reserve_idx_{0};
+
+    // futex word consumers sleep on; push bumps it only while someone is waiting
+    // process-shared futex, so no FUTEX_PRIVATE_FLAG
+    alignas(64) std::atomic<uint32_t> wake_seq_{0};
+    std::atomic<uint32_t> waiters_{0};
+
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) &&
+                  std::atomic<uint32_t>::is_always_lock_free, "futex word must be a plain uint32");
 };
 
-template <typename T, std::size_t Capacity>
-void BroadcastQueue<T, Capacity>::push(const T& item) {
+template <typename T>
+std::size_t BroadcastQueue<T>::bytes_for(std::size_t capacity) {
+    return seq_offset() + align_up(capacity * sizeof(std::atomic<std::size_t>)) + capacity * sizeof(T);
+}
+
+template <typename T>
+BroadcastQueue<T>* BroadcastQueue<T>::create(void* memory, std::size_t capacity, bool multi_producer) {
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0) return nullptr;
+
+    auto* queue = new (memory) BroadcastQueue(capacity, multi_producer);
+    std::atomic<std::size_t>* seq = queue->seq();
+    for (std::size_t i = 0; i < capacity; ++i) new (&seq[i]) std::atomic<std::size_t>(0);
+    return queue;
+}
+
+template <typename T>
+void BroadcastQueue<T>::push_sp(const T& item) {
     // only one writer, relaxed is good
     std::size_t idx = write_idx_.load(std::memory_order_relaxed);
-    buffer_[idx & (Capacity - 1)] = item;
+    std::size_t slot = idx & mask_;
+
+    // mark the slot as being written before touching the data
+    seq()[slot].store(2 * idx + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    buffer()[slot] = item;
+
+    seq()[slot].store(2 * idx + 2, std::memory_order_release);
     write_idx_.store(idx + 1, std::memory_order_release);
+
+    wake_waiters();
 }
 
-template <typename T, std::size_t Capacity>
+template <typename T>
+void BroadcastQueue<T>::push_mp(const T& item) {
+    std::size_t idx = reserve_idx_.fetch_add(1, std::memory_order_relaxed);
+    std::size_t slot = idx & mask_;
+
+    // the item a lap back must be published before its slot is reused, otherwise publication
+    // would wait on a sequence word that no longer exists; only a producer stalled for a whole
+    // lap mid-push can make this wait, so after a short spin nap to let it run
+    // (polling rather than a futex, which would make every other push pay for a wake call)
+    for (int spins = 0; idx >= capacity_ && write_idx_.load(std::memory_order_acquire) <= idx - capacity_;) {
+        if (++spins < 64) {
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#endif
+            continue;
+        }
+        timespec nap{0, 20000};
+        nanosleep(&nap, nullptr);
+    }
+
+    seq()[slot].store(2 * idx + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    buffer()[slot] = item;
+
+    // per-slot commit flag: the even sequence word
+    seq()[slot].store(2 * idx + 2, std::memory_order_seq_cst);
+
+    // publish the committed prefix: whoever commits the slot at write_idx_ carries the index past
+    // every later slot already committed, so nobody waits for a slower producer to finish
+    // seq_cst on both sides: either we see a later producer's commit, or it sees our new index
+    std::size_t w = write_idx_.load(std::memory_order_seq_cst);
+    while (seq()[w & mask_].load(std::memory_order_seq_cst) == 2 * w + 2) {
+        if (write_idx_.compare_exchange_weak(w, w + 1, std::memory_order_seq_cst)) ++w;
+    }
+
+    wake_waiters();
+}
+
+template <typename T>
+void BroadcastQueue<T>::wake_waiters() {
+    // pairs with the fence in wait_for_data: either we see the waiter or it sees the new index
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters_.load(std::memory_order_relaxed) != 0) {
+        wake_seq_.fetch_add(1, std::memory_order_release);
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&wake_seq_), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+    }
+}
+
+template <typename T>
+bool BroadcastQueue<T>::read(std::size_t pos, T& out) const {
+    std::size_t slot = pos & mask_;
+    std::size_t expected = 2 * pos + 2;
+
+    if (seq()[slot].load(std::memory_order_acquire) != expected) return false;
+    memcpy(&out, &buffer()[slot], sizeof(T));
+
+    // the copy must finish before the sequence is re-checked
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return seq()[slot].load(std::memory_order_relaxed) == expected;
+}
+
+template <typename T>
 template <typename Callback>
-void BroadcastQueue<T, Capacity>::consume(std::size_t& consumer_pos, Callback callback) {
+std::size_t BroadcastQueue<T>::consume(std::size_t& consumer_pos, Callback callback) {
     std::size_t idx = write_idx_.load(std::memory_order_acquire);
+    std::size_t dropped = 0;
 
     while(consumer_pos < idx) {
-        callback(buffer_[consumer_pos++ & (Capacity - 1)]);
+        T item;
+        if (read(consumer_pos, item)) {
+            ++consumer_pos;
+            callback(item);
+            continue;
+        }
 
+        // lapped: the slot at write_idx - capacity may be mid-write, so resume one past it
+        idx = write_idx_.load(std::memory_order_acquire);
+        std::size_t oldest = idx >= capacity_ ? idx - capacity_ + 1 : 0;
+        if (consumer_pos < oldest) {
+            dropped += oldest - consumer_pos;
+            consumer_pos = oldest;
+        } else {
+            // slot doesn't hold what the index promises (e.g. the writer restarted); skip it
+            ++dropped;
+            ++consumer_pos;
+        }
     }
+
+    return dropped;
+}
+
+template <typename T>
+typename BroadcastQueue<T>::Batch
+BroadcastQueue<T>::peek_batch(std::size_t consumer_pos, std::size_t max_items) const {
+    std::size_t idx = write_idx_.load(std::memory_order_acquire);
+
+    // items below idx are complete; the slot of idx - capacity may be mid-write
+    std::size_t begin = consumer_pos;
+    std::size_t oldest = idx >= capacity_ ? idx - capacity_ + 1 : 0;
+    if (begin < oldest) begin = oldest;
+    std::size_t end = idx;
+    if (end > begin + max_items) end = begin + max_items;
+    if (end < begin) end = begin;
+
+    std::size_t slot = begin & mask_;
+    std::size_t count = end - begin;
+    std::size_t first_len = count < capacity_ - slot ? count : capacity_ - slot;
+
+    Batch batch;
+    batch.first = &buffer()[slot];
+    batch.first_len = first_len;
+    batch.second = &buffer()[0];
+    batch.second_len = count - first_len;
+    batch.begin = begin;
+    batch.dropped = begin - consumer_pos;
+    return batch;
 }
 
-template <typename T, std::size_t Capacity>
-std::size_t BroadcastQueue<T, Capacity>::current_pos() const {
+template <typename T>
+std::size_t BroadcastQueue<T>::commit(std::size_t& consumer_pos, const Batch& batch) const {
+    // every read of the batch must happen before the index is sampled
+    std::atomic_thread_fence(std::memory_order_acquire);
+    std::size_t idx = write_idx_.load(std::memory_order_relaxed);
+
+    // multi-producer: reserved positions past write_idx_ may already be writing their slots
+    std::size_t reserved = reserve_idx_.load(std::memory_order_relaxed);
+    if (reserved > idx) idx = reserved;
+
+    // writes up to and including position idx may have touched positions up to idx - capacity
+    std::size_t end = batch.begin + batch.size();
+    consumer_pos = end;
+    if (idx < capacity_ || idx - capacity_ < batch.begin) return 0;
+    std::size_t clobbered = idx - capacity_ + 1 - batch.begin;
+    return clobbered < batch.size() ? clobbered : batch.size();
+}
+
+template <typename T>
+std::size_t BroadcastQueue<T>::current_pos() const {
     return write_idx_.load(std::memory_order_acquire);
 }
 
+template <typename T>
+bool BroadcastQueue<T>::wait_for_data(std::size_t consumer_pos, std::chrono::nanoseconds timeout) {
+    if (write_idx_.load(std::memory_order_acquire) > consumer_pos) return true;
+
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    bool ready = false;
+
+    waiters_.fetch_add(1, std::memory_order_relaxed);
+    for (;;) {
+        uint32_t word = wake_seq_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (write_idx_.load(std::memory_order_acquire) > consumer_pos) {
+            ready = true;
+            break;
+        }
+
+        auto remaining = deadline - std::chrono::steady_clock::now();
+        if (remaining <= std::chrono::nanoseconds::zero()) break;
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(remaining).count();
+        timespec ts{static_cast<time_t>(ns / 1000000000), static_cast<long>(ns % 1000000000)};
+
+        // returns early with EAGAIN if push bumped the word after we read it
+        long rc = syscall(SYS_futex, reinterpret_cast<uint32_t*>(&wake_seq_), FUTEX_WAIT, word, &ts, nullptr, 0);
+        if (rc == -1 && errno == EINTR) break;
+    }
+    waiters_.fetch_sub(1, std::memory_order_relaxed);
+
+    return ready;
+}
 
 #endif
@@ -21,6 +21,45 @@ static WidgetType parse_widget_type(std::string_view s) {
   throw std::invalid_argument("unknown widget type: " + std::string(s));
 }
 
+static TraceLevel parse_trace_level(std::string_view s) {
+  if (s == "off")
+    return TraceLevel::OFF;
+  if (s == "frames")
+    return TraceLevel::FRAMES;
+  if (s == "signals")
+    return TraceLevel::SIGNALS;
+  throw std::invalid_argument("unknown trace level: " + std::string(s));
+}
+
+static PublishMode parse_publish_mode(std::string_view s) {
+  if (s == "always")
+    return PublishMode::ALWAYS;
+  if (s == "on_change")
+    return PublishMode::ON_CHANGE;
+  if (s == "deadband")
+    return PublishMode::DEADBAND;
+  if (s == "rate")
+    return PublishMode::RATE;
+  throw std::invalid_argument("unknown publish policy: " + std::string(s));
+}
+
+// { "policy": ..., "deadband": x, "max_hz": n, "heartbeat_ms": t }
+static PublishPolicy parse_publish_policy(const nlohmann::json &j) {
+  PublishPolicy p;
+  p.mode = parse_publish_mode(j.value("policy", std::string("always")));
+  p.deadband = j.value("deadband", p.deadband);
+  double max_hz = j.value("max_hz", 0.0);
+  double heartbeat_ms = j.value("heartbeat_ms", 0.0);
+  if (p.mode == PublishMode::RATE && max_hz <= 0.0)
+    throw std::invalid_argument("publish policy \"rate\" needs max_hz > 0");
+  if (p.deadband < 0.0 || heartbeat_ms < 0.0)
+    throw std::invalid_argument("publish deadband and heartbeat_ms must not be negative");
+  if (max_hz > 0.0)
+    p.min_interval_ns = static_cast<uint64_t>(1e9 / max_hz);
+  p.heartbeat_ns = static_cast<uint64_t>(heartbeat_ms * 1e6);
+  return p;
+}
+
 static DataUnit parse_data_unit(std::string_view s) {
   if (s == "temperature")
     return DataUnit::Temperature;
@@ -74,3 +113,89 @@ DisplayConfig load_display_config(const std::string &path) {
 
   return result;
 }
+
+CanReaderConfig load_reader_config(const std::string &path) {
+  CanReaderConfig result;
+  auto j = parse_json_file(path);
+  if (j.is_null())
+    return result;
+
+  if (j.contains("queue")) {
+    const auto &q = j["queue"];
+    QueueConfig &cfg = result.queue;
+    cfg.capacity = q.value("capacity", cfg.capacity);
+    cfg.populate = q.value("populate", cfg.populate);
+    cfg.lock = q.value("lock", cfg.lock);
+    cfg.hugepages = q.value("hugepages", cfg.hugepages);
+    cfg.multi_producer = q.value("multi_producer", cfg.multi_producer);
+    if (cfg.capacity == 0 || (cfg.capacity & (cfg.capacity - 1)) != 0)
+      throw std::invalid_argument("queue capacity must be a power of 2: " +
+                                  std::to_string(cfg.capacity));
+  }
+
+  if (j.contains("backpressure")) {
+    const auto &b = j["backpressure"];
+    BackpressureConfig &cfg = result.backpressure;
+    cfg.warn_lag = b.value("warn_lag", cfg.warn_lag);
+    cfg.decimate_lag = b.value("decimate_lag", cfg.decimate_lag);
+    cfg.decimate_keep = b.value("decimate_keep", cfg.decimate_keep);
+    if (b.contains("low_priority"))
+      cfg.low_priority = b["low_priority"].get<std::vector<std::string>>();
+    cfg.spill_capacity = b.value("spill_capacity", cfg.spill_capacity);
+    if (b.contains("stale_ms"))
+      cfg.stale_ns = b["stale_ms"].get<uint64_t>() * 1000000;
+    if (b.contains("check_ms"))
+      cfg.check_ns = b["check_ms"].get<uint64_t>() * 1000000;
+    if (!(cfg.warn_lag > 0.0 && cfg.warn_lag <= cfg.decimate_lag && cfg.decimate_lag <= 1.0))
+      throw std::invalid_argument(
+          "backpressure: need 0 < warn_lag <= decimate_lag <= 1");
+    if (cfg.decimate_keep == 0)
+      throw std::invalid_argument("backpressure: decimate_keep must be at least 1");
+    if ((cfg.spill_capacity & (cfg.spill_capacity - 1)) != 0)
+      throw std::invalid_argument(
+          "backpressure: spill_capacity must be a power of 2: " +
+          std::to_string(cfg.spill_capacity));
+    if (cfg.check_ns == 0)
+      throw std::invalid_argument("backpressure: check_ms must be at least 1");
+  }
+
+  if (j.contains("trace"))
+    result.trace = parse_trace_level(j["trace"].get<std::string>());
+
+  if (j.contains("publish")) {
+    const auto &p = j["publish"];
+    if (p.contains("default"))
+      result.default_publish = parse_publish_policy(p["default"]);
+    if (p.contains("signals")) {
+      for (const auto &[name, policy] : p["signals"].items())
+        result.publish[name] = parse_publish_policy(policy);
+    }
+  }
+
+  if (j.contains("derived")) {
+    for (const auto &d : j["derived"]) {
+      DerivedConfig derived;
+      derived.name = d["name"];
+      derived.expr = d["expr"];
+      result.derived.push_back(derived);
+    }
+  }
+
+  if (j.contains("buses")) {
+    result.buses.clear();
+    for (const auto &b : j["buses"]) {
+      BusConfig bus;
+      bus.interface = b.value("interface", bus.interface);
+      bus.dbc_path = b.value("dbc", bus.dbc_path);
+      bus.cpu = b.value("cpu", bus.cpu);
+      result.buses.push_back(bus);
+    }
+    if (result.buses.empty() ||
+        result.buses.size() > static_cast<std::size_t>(MAX_BUSES))
+      throw std::invalid_argument("buses: between 1 and " +
+                                  std::to_string(MAX_BUSES) +
+                                  " interfaces are supported");
+  }
+
+  return result;
+}
@@ -3,6 +3,11 @@
 
 #include "config_types.hpp"
 
+constexpr const char* DEFAULT_READER_CONFIG_PATH = "/tmp/can-reader.json";
+
 DisplayConfig load_display_config(const std::string& path);
 
+// missing file or keys fall back to the defaults in config_types.hpp
+CanReaderConfig load_reader_config(const std::string& path);
+
 #endif
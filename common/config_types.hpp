@@ -7,37 +7,140 @@
 #include <vector>
 #include <cstring>
 
+inline constexpr uint16_t INVALID_SIGNAL_ID = 0xFFFF;
+
+// 24 bytes; signal_id resolves to a CAN ID and name through the SignalTable in shared memory
 struct TelemetryMessage {
-    uint32_t can_id;
-    char signal_name[64];
+    uint16_t signal_id;
+    uint16_t _pad;
+    uint32_t queue_delay_ns;    // kernel RX -> pushed into the queue, saturating; set by TelemetryPublisher
     double value;
+    uint64_t ingest_ns;         // kernel RX time of the frame, CLOCK_MONOTONIC ns
+
+    // CLOCK_MONOTONIC ns at which it was pushed into the queue
+    uint64_t queued_ns() const { return ingest_ns + queue_delay_ns; }
 };
+static_assert(sizeof(TelemetryMessage) == 24);
 
 // CAN frame config types
+
+// how the raw bits of a signal are interpreted
 enum class SignalType {
-    UINT8,
-    INT8,
-    UINT16,
-    INT16,
-    UINT32,
-    INT32,
-    FLOAT,
-    DOUBLE
+    UNSIGNED,
+    SIGNED,
+    FLOAT,      // IEEE 754 single, 32 bits (DBC SIG_VALTYPE_ 1)
+    DOUBLE      // IEEE 754 double, 64 bits (DBC SIG_VALTYPE_ 2)
+};
+
+// DBC @1 is little-endian (Intel), @0 is big-endian (Motorola)
+enum class ByteOrder {
+    INTEL,
+    MOTOROLA
+};
+
+// DBC multiplexing: the M signal selects which m<n> signals the frame carries
+enum class MuxRole : uint8_t {
+    NONE,           // present in every frame
+    MULTIPLEXOR,    // "M": its raw value selects the page
+    MULTIPLEXED     // "m<n>": present only when the multiplexor reads mux_value
+};
+
+// when can-reader pushes a decoded value to the telemetry queue
+enum class PublishMode : uint8_t {
+    ALWAYS,         // every frame
+    ON_CHANGE,      // value differs from the last one published
+    DEADBAND,       // value moved more than `deadband` from the last one published
+    RATE            // at most once per min_interval_ns
+};
+
+inline constexpr int PUBLISH_MODES = 4;
+
+struct PublishPolicy {
+    PublishMode mode = PublishMode::ALWAYS;
+    double deadband = 0.0;
+    uint64_t min_interval_ns = 0;   // RATE: 1 s / max_hz
+    uint64_t heartbeat_ns = 0;      // republish an unchanged value after this long, 0 = never
 };
 
 struct ChannelConfig {
     std::string name;
-    uint8_t start_byte;
-    uint8_t length;
+    uint16_t start_bit;     // DBC numbering: LSB for little-endian, MSB for big-endian
+    uint8_t bit_length;
+    ByteOrder byte_order;
     SignalType type;
     double scale;
     double offset;
+    uint16_t signal_id = INVALID_SIGNAL_ID;     // assigned by intern_signals at load time
+    uint8_t frame_bytes = 8;                    // payload length of the message: 8 classic, up to 64 CAN FD
+    MuxRole mux = MuxRole::NONE;
+    uint16_t mux_value = 0;                     // page for MULTIPLEXED signals
+    PublishPolicy publish;                      // from the reader config, by signal name
 };
 
 
 // maps can ID to a list of channels that exist in that frame
 using FrameMap = std::unordered_map<uint32_t, std::vector<ChannelConfig>>;
 
+// can-reader process config
+
+// shared telemetry ring; readers take the geometry from the segment header
+struct QueueConfig {
+    std::size_t capacity = 16384;   // messages, power of 2
+    bool populate = true;           // pre-fault the mapping (MAP_POPULATE)
+    bool lock = false;              // mlock the ring so it can never be paged out
+    bool hugepages = false;         // ask for transparent huge pages (MADV_HUGEPAGE)
+    bool multi_producer = false;    // let other threads and processes push alongside can-reader
+};
+
+// can-reader trace verbosity, each level includes the ones before it
+enum class TraceLevel : uint8_t {
+    OFF,
+    FRAMES,     // every received frame
+    SIGNALS     // every decoded signal as well
+};
+
+// most CAN interfaces one can-reader ingests (sizes the per-bus stats in shared memory)
+inline constexpr int MAX_BUSES = 4;
+
+// one CAN interface and the DBC describing the traffic on it
+struct BusConfig {
+    std::string interface = "vcan0";
+    std::string dbc_path = "/tmp/display.dbc";     // DEFAULT_DBC_PATH
+    int cpu = -1;                   // core to pin the bus thread to, -1 = unpinned
+};
+
+// CAN ID derived channels are published under; CAN_ERR_FLAG, so it never names a data frame
+inline constexpr uint32_t DERIVED_CAN_ID = 0x20000000;
+
+// a channel computed from other signals, e.g. "pack_voltage * pack_current"
+// inputs are signal names, or name@<hex CAN ID> where a name appears in several frames
+struct DerivedConfig {
+    std::string name;
+    std::string expr;
+};
+
+// what can-reader does when a consumer registered in the stats segment falls behind
+// lags are fractions of the queue capacity
+struct BackpressureConfig {
+    double warn_lag = 0.5;              // log a warning
+    double decimate_lag = 0.75;         // thin out low-priority signals (lossy consumers only)
+    uint32_t decimate_keep = 4;         // while decimating, publish 1 in n values of each low-priority signal
+    std::vector<std::string> low_priority;  // signal names that may be decimated
+    std::size_t spill_capacity = 0;     // records kept for a lossless consumer, power of 2; 0 = no spilling
+    uint64_t stale_ns = 2000000000;     // a consumer without a heartbeat for this long is ignored
+    uint64_t check_ns = 100000000;      // how often lags are sampled
+};
+
+struct CanReaderConfig {
+    QueueConfig queue;
+    BackpressureConfig backpressure;
+    PublishPolicy default_publish;
+    std::unordered_map<std::string, PublishPolicy> publish;    // per signal name, overrides the default
+    std::vector<DerivedConfig> derived;     // evaluated in order; may use channels defined before them
+    TraceLevel trace = TraceLevel::OFF;     // can be changed with SIGHUP
+    std::vector<BusConfig> buses{BusConfig{}};
+};
+
 // Display config types — mirrors graphics.types.ts
 
 enum class WidgetType { Gauge, Bar, Number, Indicator };
@@ -5,17 +5,33 @@
 
 #include "dbc_parser.hpp"
 
-// derive SignalType from bit length and signedness
-static SignalType derive_signal_type(int bit_length, bool is_signed) {
-    switch (bit_length) {
-        case 8:  return is_signed ? SignalType::INT8  : SignalType::UINT8;
-        case 16: return is_signed ? SignalType::INT16 : SignalType::UINT16;
-        case 32: return is_signed ? SignalType::INT32 : SignalType::UINT32;
-        case 64: return SignalType::DOUBLE;
-        default:
-            throw std::invalid_argument(
-                "unsupported signal bit length: " + std::to_string(bit_length));
+// validate bit length against the value type it will be decoded as
+static void check_signal_length(const std::string& name, int bit_length, SignalType type) {
+    if (bit_length < 1 || bit_length > 64) {
+        throw std::invalid_argument(
+            "unsupported bit length for signal '" + name + "': " + std::to_string(bit_length));
     }
+    if ((type == SignalType::FLOAT && bit_length != 32) ||
+        (type == SignalType::DOUBLE && bit_length != 64)) {
+        throw std::invalid_argument(
+            "floating point signal '" + name + "' has bit length " + std::to_string(bit_length));
+    }
+}
+
+// "M" marks the multiplexor, "m<n>" a signal on page n
+// extended multiplexing ("m<n>M", nested selectors) is read as a plain page n signal
+static void set_mux_role(ChannelConfig& cfg, const std::string& mux) {
+    if (mux.empty()) return;
+    if (mux == "M") {
+        cfg.mux = MuxRole::MULTIPLEXOR;
+        return;
+    }
+    unsigned long page = std::stoul(mux.substr(1));
+    if (page > 0xFFFF) {
+        throw std::invalid_argument("mux value of signal '" + cfg.name + "' out of range: " + mux);
+    }
+    cfg.mux = MuxRole::MULTIPLEXED;
+    cfg.mux_value = static_cast<uint16_t>(page);
 }
 
 FrameMap load_dbc_config(const std::string& path) {
@@ -26,11 +42,15 @@ FrameMap load_dbc_config(const std::string& path) {
     // BO_ <id> <name>: <dlc> <sender>
     std::regex bo_re(R"(^BO_\s+(\d+)\s+(\w+)\s*:\s*(\d+)\s+(\w+))");
 
-    // SG_ <name> : <start_bit>|<bit_length>@<byte_order><sign> (<scale>,<offset>) [<min>|<max>] "<unit>" <receivers>
-    std::regex sg_re(R"(^\s+SG_\s+(\w+)\s*:\s*(\d+)\|(\d+)@([01])([+-])\s*\(([^,]+),([^)]+)\))");
+    // SG_ <name> [M|m<n>] : <start_bit>|<bit_length>@<byte_order><sign> (<scale>,<offset>) [<min>|<max>] "<unit>" <receivers>
+    std::regex sg_re(R"(^\s+SG_\s+(\w+)\s*(M|m\d+M?)?\s*:\s*(\d+)\|(\d+)@([01])([+-])\s*\(([^,]+),([^)]+)\))");
+
+    // SIG_VALTYPE_ <id> <name> : <1 = float, 2 = double>;
+    std::regex valtype_re(R"(^SIG_VALTYPE_\s+(\d+)\s+(\w+)\s*:\s*([12]))");
 
     std::string line;
     uint32_t current_id = 0;
+    int current_bytes = 8;
     bool in_message = false;
 
     while (std::getline(file, line)) {
@@ -38,31 +58,55 @@ FrameMap load_dbc_config(const std::string& path) {
 
         if (std::regex_search(line, match, bo_re)) {
             current_id = static_cast<uint32_t>(std::stoul(match[1].str()));
+            // payload length in bytes; CAN FD messages go up to 64
+            current_bytes = std::stoi(match[3].str());
+            if (current_bytes > 64) {
+                throw std::invalid_argument(
+                    "message " + match[2].str() + " is longer than 64 bytes: " + match[3].str());
+            }
             in_message = true;
             continue;
         }
 
         if (in_message && std::regex_search(line, match, sg_re)) {
             std::string name = match[1].str();
-            int start_bit    = std::stoi(match[2].str());
-            int bit_length   = std::stoi(match[3].str());
-            // match[4] = byte order: 1 = little-endian, 0 = big-endian
-            char sign        = match[5].str()[0];
-            double scale     = std::stod(match[6].str());
-            double offset    = std::stod(match[7].str());
+            std::string mux  = match[2].str();
+            int start_bit    = std::stoi(match[3].str());
+            int bit_length   = std::stoi(match[4].str());
+            char order       = match[5].str()[0];
+            char sign        = match[6].str()[0];
+            double scale     = std::stod(match[7].str());
+            double offset    = std::stod(match[8].str());
 
             ChannelConfig cfg;
             cfg.name       = name;
-            cfg.start_byte = static_cast<uint8_t>(start_bit / 8);
-            cfg.length     = static_cast<uint8_t>(bit_length / 8);
-            cfg.type       = derive_signal_type(bit_length, sign == '-');
+            cfg.start_bit  = static_cast<uint16_t>(start_bit);
+            cfg.bit_length = static_cast<uint8_t>(bit_length);
+            cfg.byte_order = order == '1' ? ByteOrder::INTEL : ByteOrder::MOTOROLA;
+            cfg.type       = sign == '-' ? SignalType::SIGNED : SignalType::UNSIGNED;
             cfg.scale      = scale;
             cfg.offset     = offset;
+            cfg.frame_bytes = static_cast<uint8_t>(current_bytes < 8 ? 8 : current_bytes);
+            set_mux_role(cfg, mux);
 
+            check_signal_length(name, bit_length, cfg.type);
             result[current_id].emplace_back(cfg);
             continue;
         }
 
+        // value types follow all messages, so they patch signals already parsed
+        if (std::regex_search(line, match, valtype_re)) {
+            uint32_t id = static_cast<uint32_t>(std::stoul(match[1].str()));
+            auto it = result.find(id);
+            if (it == result.end()) continue;
+            for (auto& cfg : it->second) {
+                if (cfg.name != match[2].str()) continue;
+                cfg.type = match[3].str() == "1" ? SignalType::FLOAT : SignalType::DOUBLE;
+                check_signal_length(cfg.name, cfg.bit_length, cfg.type);
+            }
+            continue;
+        }
+
         // a non-indented, non-empty line that isn't a signal ends the current message
         if (in_message && !line.empty() && line[0] != ' ' && line[0] != '\t') {
             in_message = false;
@@ -0,0 +1,119 @@
+#ifndef FSAE_LATENCY_HISTOGRAM_HPP
+#define FSAE_LATENCY_HISTOGRAM_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+
+// CLOCK_MONOTONIC in ns, the clock TelemetryMessage::ingest_ns is stamped on
+inline uint64_t monotonic_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+struct LatencySummary {
+    uint64_t count;
+    uint64_t p50_ns;
+    uint64_t p90_ns;
+    uint64_t p99_ns;
+    uint64_t p999_ns;
+    uint64_t max_ns;
+};
+
+// log-linear histogram of nanosecond durations: 8 buckets per power of two (<= 12.5% error)
+// record() is a relaxed increment, so any thread may record while another reads;
+// all-zero is a valid empty histogram, so it can live in zero-filled shared memory
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BITS = 3;
+    static constexpr int SUB_BUCKETS = 1 << SUB_BITS;
+    static constexpr int BUCKETS = (64 - SUB_BITS + 1) * SUB_BUCKETS;
+
+    void record(uint64_t ns) {
+        buckets_[bucket_of(ns)].fetch_add(1, std::memory_order_relaxed);
+        uint64_t seen = max_.load(std::memory_order_relaxed);
+        while (ns > seen && !max_.compare_exchange_weak(seen, ns, std::memory_order_relaxed)) {}
+    }
+
+    // record the time since a monotonic_ns() stamp; stamps from the future count as 0
+    void record_since(uint64_t start_ns, uint64_t now_ns) {
+        record(now_ns > start_ns ? now_ns - start_ns : 0);
+    }
+
+    // upper bound of the bucket holding the q-th quantile (0 < q <= 1); 0 if empty
+    uint64_t percentile(double q) const;
+
+    LatencySummary summary() const;
+
+    void reset() {
+        for (auto& b : buckets_) b.store(0, std::memory_order_relaxed);
+        max_.store(0, std::memory_order_relaxed);
+    }
+
+    static int bucket_of(uint64_t ns) {
+        if (ns < SUB_BUCKETS) return static_cast<int>(ns);
+        int exp = 63 - __builtin_clzll(ns);
+        int sub = static_cast<int>(ns >> (exp - SUB_BITS)) & (SUB_BUCKETS - 1);
+        return (exp - SUB_BITS + 1) * SUB_BUCKETS + sub;
+    }
+
+    // largest value that falls in bucket b
+    static uint64_t bucket_upper(int b) {
+        if (b < SUB_BUCKETS) return static_cast<uint64_t>(b);
+        int exp = b / SUB_BUCKETS + SUB_BITS - 1;
+        uint64_t sub = static_cast<uint64_t>(b % SUB_BUCKETS);
+        uint64_t lower = (SUB_BUCKETS + sub) << (exp - SUB_BITS);
+        return lower + (uint64_t{1} << (exp - SUB_BITS)) - 1;
+    }
+
+private:
+    std::atomic<uint64_t> buckets_[BUCKETS]{};
+    std::atomic<uint64_t> max_{0};
+};
+
+inline uint64_t LatencyHistogram::percentile(double q) const {
+    uint64_t counts[BUCKETS];
+    uint64_t total = 0;
+    for (int b = 0; b < BUCKETS; ++b) {
+        counts[b] = buckets_[b].load(std::memory_order_relaxed);
+        total += counts[b];
+    }
+    if (total == 0) return 0;
+
+    uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(total));
+    if (rank == 0) rank = 1;
+    uint64_t seen = 0;
+    for (int b = 0; b < BUCKETS; ++b) {
+        seen += counts[b];
+        if (seen >= rank) {
+            uint64_t upper = bucket_upper(b);
+            uint64_t max = max_.load(std::memory_order_relaxed);
+            return upper < max ? upper : max;
+        }
+    }
+    return max_.load(std::memory_order_relaxed);
+}
+
+inline LatencySummary LatencyHistogram::summary() const {
+    LatencySummary s;
+    s.count = 0;
+    for (const auto& b : buckets_) s.count += b.load(std::memory_order_relaxed);
+    s.p50_ns = percentile(0.50);
+    s.p90_ns = percentile(0.90);
+    s.p99_ns = percentile(0.99);
+    s.p999_ns = percentile(0.999);
+    s.max_ns = max_.load(std::memory_order_relaxed);
+    return s;
+}
+
+// one line of percentiles in microseconds, e.g. for exit reports
+inline void print_latency(const char* stage, const LatencyHistogram& hist) {
+    LatencySummary s = hist.summary();
+    std::printf("%-18s %10llu samples  p50 %9.1f us  p90 %9.1f us  p99 %9.1f us  p99.9 %9.1f us  max %9.1f us\n",
+                stage, static_cast<unsigned long long>(s.count), s.p50_ns / 1e3, s.p90_ns / 1e3,
+                s.p99_ns / 1e3, s.p999_ns / 1e3, s.max_ns / 1e3);
+}
+
+#endif
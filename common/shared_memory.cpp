@@ -1,27 +1,313 @@
 #include "shared_memory.hpp"
 #include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/file.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <dirent.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
 
-TelemetryQueue* open_shared_queue(bool is_writer) {
-    int fd = shm_open(SHM_NAME, O_RDWR | (is_writer ? O_CREAT : 0), 0666);
+static void* payload_of(SegmentHeader* header) {
+    return reinterpret_cast<char*>(header) + SEGMENT_HEADER_SIZE;
+}
+
+static SegmentHeader* header_of(void* payload) {
+    return reinterpret_cast<SegmentHeader*>(static_cast<char*>(payload) - SEGMENT_HEADER_SIZE);
+}
+
+// create a fresh segment and fill in its header; the caller publishes it once the payload is built
+// replace: unlink any existing segment first, otherwise fail with EEXIST if one is there
+static SegmentHeader* create_segment(const char* name, uint32_t element_size, uint64_t capacity,
+                                     std::size_t payload_size, const QueueConfig& config, bool replace = true) {
+    // a new object rather than resizing the old one, so stale readers keep a valid mapping
+    if (replace) shm_unlink(name);
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0666);
     if (fd == -1) return nullptr;
 
-    if(is_writer && ftruncate(fd, sizeof(TelemetryQueue)) == -1) {
+    std::size_t size = SEGMENT_HEADER_SIZE + payload_size;
+    if(ftruncate(fd, size) == -1) {
         ::close(fd);
         return nullptr;
     }
 
-    void* ptr = mmap(nullptr, sizeof(TelemetryQueue), PROT_WRITE | PROT_READ, MAP_SHARED, fd, 0);
+    // huge pages have to be requested before the first touch, so populate by hand in that case
+    int flags = MAP_SHARED | (config.populate && !config.hugepages ? MAP_POPULATE : 0);
+    void* ptr = mmap(nullptr, size, PROT_WRITE | PROT_READ, flags, fd, 0);
     ::close(fd);
     if (ptr == MAP_FAILED) return nullptr;
 
-    if(is_writer) new (ptr) TelemetryQueue(); // placement new to construct the queue in shared memory
+    if (config.hugepages) {
+        madvise(ptr, size, MADV_HUGEPAGE);
+        if (config.populate) memset(ptr, 0, size);
+    }
+    if (config.lock && mlock(ptr, size) == -1) {
+        std::perror("mlock shared memory");
+    }
+
+    auto* header = new (ptr) SegmentHeader();
+    header->version = SEGMENT_LAYOUT_VERSION;
+    header->element_size = element_size;
+    header->capacity = capacity;
+    header->total_size = size;
+    return header;
+}
+
+static void publish_segment(SegmentHeader* header) {
+    header->magic.store(SEGMENT_MAGIC, std::memory_order_release);
+}
+
+// map an existing segment, refusing one this build can't read
+static SegmentHeader* attach_segment(const char* name, uint32_t element_size, const QueueConfig& config) {
+    int fd = shm_open(name, O_RDWR, 0666);
+    if (fd == -1) return nullptr;
+
+    struct stat st;
+    if (fstat(fd, &st) == -1 || static_cast<std::size_t>(st.st_size) < SEGMENT_HEADER_SIZE) {
+        ::close(fd);
+        errno = EAGAIN;     // writer hasn't sized it yet
+        return nullptr;
+    }
+
+    std::size_t size = st.st_size;
+    int flags = MAP_SHARED | (config.populate ? MAP_POPULATE : 0);
+    void* ptr = mmap(nullptr, size, PROT_WRITE | PROT_READ, flags, fd, 0);
+    ::close(fd);
+    if (ptr == MAP_FAILED) return nullptr;
+
+    auto* header = static_cast<SegmentHeader*>(ptr);
+    if (header->magic.load(std::memory_order_acquire) != SEGMENT_MAGIC) {
+        munmap(ptr, size);
+        errno = EAGAIN;     // writer hasn't published it yet
+        return nullptr;
+    }
+    if (header->version != SEGMENT_LAYOUT_VERSION || header->element_size != element_size ||
+        header->total_size != size) {
+        std::fprintf(stderr, "%s: incompatible layout (version %u, %u-byte elements; expected version %u, %u-byte elements)\n",
+                     name, header->version, header->element_size, SEGMENT_LAYOUT_VERSION, element_size);
+        munmap(ptr, size);
+        errno = EPROTO;
+        return nullptr;
+    }
+
+    if (config.lock && mlock(ptr, size) == -1) {
+        std::perror("mlock shared memory");
+    }
+    return header;
+}
+
+static void close_segment(void* payload, const char* name, bool is_writer) {
+    SegmentHeader* header = header_of(payload);
+    munmap(header, header->total_size);
+    if(is_writer) shm_unlink(name);
+}
+
+TelemetryQueue* open_shared_queue(bool is_writer, const QueueConfig& config) {
+    if (!is_writer) {
+        SegmentHeader* header = attach_segment(SHM_NAME, sizeof(TelemetryMessage), config);
+        if (!header) return nullptr;
+        auto* queue = static_cast<TelemetryQueue*>(payload_of(header));
+        if (queue->capacity() != header->capacity ||
+            TelemetryQueue::bytes_for(header->capacity) + SEGMENT_HEADER_SIZE != header->total_size) {
+            close_segment(queue, SHM_NAME, false);
+            errno = EPROTO;
+            return nullptr;
+        }
+        return queue;
+    }
+
+    SegmentHeader* header = create_segment(SHM_NAME, sizeof(TelemetryMessage), config.capacity,
+                                           TelemetryQueue::bytes_for(config.capacity), config);
+    if (!header) return nullptr;
+
+    // construct the queue in shared memory
+    TelemetryQueue* queue = TelemetryQueue::create(payload_of(header), config.capacity, config.multi_producer);
+    if (!queue) {
+        munmap(header, header->total_size);
+        shm_unlink(SHM_NAME);
+        errno = EINVAL;
+        return nullptr;
+    }
 
-    return static_cast<TelemetryQueue*>(ptr);
+    publish_segment(header);
+    return queue;
 }
 
 void close_shared_queue(TelemetryQueue* queue, bool is_writer) {
-    munmap(queue, sizeof(TelemetryQueue));
-    if(is_writer) shm_unlink(SHM_NAME);
+    close_segment(queue, SHM_NAME, is_writer);
+}
+
+SignalTable* open_signal_table(bool is_writer) {
+    QueueConfig config;     // small and read-mostly: default mapping behaviour
+    if (!is_writer) {
+        SegmentHeader* header = attach_segment(SIGNAL_SHM_NAME, sizeof(SignalTable), config);
+        return header ? static_cast<SignalTable*>(payload_of(header)) : nullptr;
+    }
+
+    SegmentHeader* header = create_segment(SIGNAL_SHM_NAME, sizeof(SignalTable), 1, sizeof(SignalTable), config);
+    if (!header) return nullptr;
+
+    auto* table = new (payload_of(header)) SignalTable();
+    publish_segment(header);
+    return table;
+}
+
+void close_signal_table(SignalTable* table, bool is_writer) {
+    close_segment(table, SIGNAL_SHM_NAME, is_writer);
+}
+
+SpillRing* open_spill_ring(bool is_writer, std::size_t capacity) {
+    QueueConfig config;
+    if (!is_writer) {
+        SegmentHeader* header = attach_segment(SPILL_SHM_NAME, sizeof(SpillRecord), config);
+        if (!header) return nullptr;
+        auto* ring = static_cast<SpillRing*>(payload_of(header));
+        if (ring->capacity() != header->capacity ||
+            SpillRing::bytes_for(header->capacity) + SEGMENT_HEADER_SIZE != header->total_size) {
+            close_segment(ring, SPILL_SHM_NAME, false);
+            errno = EPROTO;
+            return nullptr;
+        }
+        return ring;
+    }
+
+    SegmentHeader* header = create_segment(SPILL_SHM_NAME, sizeof(SpillRecord), capacity,
+                                           SpillRing::bytes_for(capacity), config);
+    if (!header) return nullptr;
+
+    SpillRing* ring = SpillRing::create(payload_of(header), capacity);
+    if (!ring) {
+        munmap(header, header->total_size);
+        shm_unlink(SPILL_SHM_NAME);
+        errno = EINVAL;
+        return nullptr;
+    }
+
+    publish_segment(header);
+    return ring;
+}
+
+void close_spill_ring(SpillRing* ring, bool is_writer) {
+    close_segment(ring, SPILL_SHM_NAME, is_writer);
+}
+
+// a process that still has segment `name` mapped, 0 if none (or /proc can't be read)
+// a different layout's pid fields can't be trusted, so this goes by /proc/<pid>/maps instead;
+// processes whose maps this one may not read (other users', other namespaces') are passed over,
+// the daemons all run as one user
+static int segment_user(const char* name) {
+    DIR* proc = opendir("/proc");
+    if (!proc) return 0;
+    std::string path = std::string("/dev/shm") + name;
+    int user = 0;
+    char line[512];
+    while (dirent* entry = readdir(proc)) {
+        int pid = std::atoi(entry->d_name);
+        if (pid <= 0) continue;
+        std::string maps = std::string("/proc/") + entry->d_name + "/maps";
+        FILE* f = std::fopen(maps.c_str(), "r");
+        if (!f) continue;
+        while (std::fgets(line, sizeof(line), f)) {
+            // unlinked copies show up as "<path> (deleted)" and don't count
+            const char* at = std::strstr(line, path.c_str());
+            if (at && std::strcmp(at + path.size(), "\n") == 0) {
+                user = pid;
+                break;
+            }
+        }
+        std::fclose(f);
+        if (user) break;
+    }
+    closedir(proc);
+    return user;
+}
+
+// unlink segment `name`, left behind with a layout other than one of `payload_size`, unless a
+// process still has it mapped (then false, errno = EPROTO); true means attach again
+// racing openers serialize on an flock of the object and act only if the name still refers to
+// it and it still has the old layout: the first one may already have put a new segment there
+static bool replace_stale_segment(const char* name, std::size_t payload_size) {
+    int fd = shm_open(name, O_RDWR, 0666);
+    if (fd == -1) return errno == ENOENT;     // already unlinked by someone else
+    if (flock(fd, LOCK_EX) == -1) {
+        int err = errno;
+        ::close(fd);
+        errno = err;
+        return false;
+    }
+
+    std::string path = std::string("/dev/shm") + name;
+    struct stat held, named;
+    bool stale = fstat(fd, &held) == 0 && stat(path.c_str(), &named) == 0 &&
+                 held.st_dev == named.st_dev && held.st_ino == named.st_ino &&
+                 static_cast<std::size_t>(held.st_size) >= SEGMENT_HEADER_SIZE;
+    if (stale) {
+        void* ptr = mmap(nullptr, SEGMENT_HEADER_SIZE, PROT_READ, MAP_SHARED, fd, 0);
+        if (ptr == MAP_FAILED) {
+            stale = false;
+        } else {
+            // still being created counts as current: only a published, mismatched header is stale
+            auto* header = static_cast<const SegmentHeader*>(ptr);
+            stale = header->magic.load(std::memory_order_acquire) == SEGMENT_MAGIC &&
+                    (header->version != SEGMENT_LAYOUT_VERSION || header->element_size != payload_size ||
+                     header->total_size != SEGMENT_HEADER_SIZE + payload_size);
+            munmap(ptr, SEGMENT_HEADER_SIZE);
+        }
+    }
+
+    bool retry = true;
+    if (stale) {
+        int user = segment_user(name);
+        if (user) {
+            std::fprintf(stderr, "%s: still in use by pid %d; stop it, or remove /dev/shm%s\n",
+                         name, user, name);
+            retry = false;
+        } else {
+            std::fprintf(stderr, "%s: no process uses it, replacing it\n", name);
+            shm_unlink(name);
+        }
+    }
+    ::close(fd);    // drops the lock
+    if (!retry) errno = EPROTO;
+    return retry;
+}
+
+StatsSegment* open_stats_segment() {
+    QueueConfig config;
+    bool replaced = false;
+    for (int attempt = 0; attempt < 100; ++attempt) {
+        SegmentHeader* header = attach_segment(STATS_SHM_NAME, sizeof(StatsSegment), config);
+        if (header) return static_cast<StatsSegment*>(payload_of(header));
+        if (errno == EAGAIN) {
+            // another process is creating it right now
+            usleep(1000);
+            continue;
+        }
+        if (errno == EPROTO && !replaced) {
+            // left behind by an older build: replace it unless something still reports into it
+            if (!replace_stale_segment(STATS_SHM_NAME, sizeof(StatsSegment))) return nullptr;
+            replaced = true;
+            continue;
+        }
+        if (errno != ENOENT) return nullptr;
+
+        // first one here creates it; ftruncate zero-fills, which is the valid initial state
+        header = create_segment(STATS_SHM_NAME, sizeof(StatsSegment), 1, sizeof(StatsSegment), config, false);
+        if (header) {
+            publish_segment(header);
+            return static_cast<StatsSegment*>(payload_of(header));
+        }
+        if (errno != EEXIST) return nullptr;
+    }
+    errno = ETIMEDOUT;
+    return nullptr;
+}
+
+void close_stats_segment(StatsSegment* stats) {
+    // never unlinked: the segment outlives every process that reports into it
+    SegmentHeader* header = header_of(stats);
+    munmap(header, header->total_size);
 }
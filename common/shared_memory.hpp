@@ -1,19 +1,71 @@
 #ifndef FSAE_SHARED_MEMORY_HPP
 #define FSAE_SHARED_MEMORY_HPP
 
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
 
 #include "broadcast_queue.hpp"
 #include "config_types.hpp"
+#include "signal_table.hpp"
+#include "spill_ring.hpp"
+#include "stats_segment.hpp"
 
 inline constexpr const char* SHM_NAME = "/fsae_telemetry";
+inline constexpr const char* SIGNAL_SHM_NAME = "/fsae_signals";
+inline constexpr const char* STATS_SHM_NAME = "/fsae_stats";
+inline constexpr const char* SPILL_SHM_NAME = "/fsae_spill";
 
-using TelemetryQueue = BroadcastQueue<TelemetryMessage, 4096>;
+inline constexpr uint32_t SEGMENT_MAGIC = 0x46534145;    // "FSAE"
+
+// bump whenever the layout of a segment or of the types stored in it changes
+inline constexpr uint32_t SEGMENT_LAYOUT_VERSION = 8;
+
+// every segment starts with this header, padded to one cache line
+// the creator fills it in, constructs the payload, then publishes magic last
+struct SegmentHeader {
+    std::atomic<uint32_t> magic;
+    uint32_t version;
+    uint32_t element_size;
+    uint32_t _pad;
+    uint64_t capacity;
+    uint64_t total_size;
+};
+
+inline constexpr std::size_t SEGMENT_HEADER_SIZE = 64;
+static_assert(sizeof(SegmentHeader) <= SEGMENT_HEADER_SIZE);
+
+// ring capacity is chosen by the writer at runtime and recorded in the segment header
+using TelemetryQueue = BroadcastQueue<TelemetryMessage>;
 
 // open queue, return pointer to shared mem
-TelemetryQueue* open_shared_queue(bool is_writer);
+// the writer sizes the ring from config; readers take the size from the header and
+// refuse (errno = EPROTO) to attach to a segment with a different layout
+// other producers attach as readers and may push only if queue->multi_producer()
+TelemetryQueue* open_shared_queue(bool is_writer, const QueueConfig& config = {});
 
 // unmap and close shared mem queue
 void close_shared_queue(TelemetryQueue* queue, bool is_writer);
 
+// open the signal ID -> name table published by can-reader
+SignalTable* open_signal_table(bool is_writer);
+
+// unmap and close the signal table
+void close_signal_table(SignalTable* table, bool is_writer);
+
+// open the spill ring can-reader keeps for a lossless consumer; the writer sizes it to
+// `capacity` records, readers get nullptr (errno = ENOENT) while spilling is off
+SpillRing* open_spill_ring(bool is_writer, std::size_t capacity = 0);
+
+// unmap and close the spill ring
+void close_spill_ring(SpillRing* ring, bool is_writer);
+
+// attach to the stats segment, creating it if this is the first process up
+// one with an incompatible layout is replaced if no running process has it mapped, and refused
+// (errno = EPROTO) otherwise
+StatsSegment* open_stats_segment();
+
+// unmap the stats segment; it is left in place for other processes and fsae-top
+void close_stats_segment(StatsSegment* stats);
+
 #endif
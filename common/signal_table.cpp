@@ -0,0 +1,48 @@
+#include "signal_table.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+uint16_t SignalTable::intern(uint32_t can_id, std::string_view name) {
+    uint16_t id = find(can_id, name);
+    if (id != INVALID_SIGNAL_ID) return id;
+
+    uint32_t n = count.load(std::memory_order_relaxed);
+    if (n >= MAX_SIGNALS) return INVALID_SIGNAL_ID;
+
+    SignalInfo& info = signals[n];
+    info.can_id = can_id;
+    std::size_t len = std::min(name.size(), SIGNAL_NAME_LEN - 1);
+    memcpy(info.name, name.data(), len);
+    info.name[len] = '\0';
+
+    // entry must be fully written before readers can see it
+    count.store(n + 1, std::memory_order_release);
+    return static_cast<uint16_t>(n);
+}
+
+uint16_t SignalTable::find(uint32_t can_id, std::string_view name) const {
+    // stored names are truncated, so compare against the truncated form
+    name = name.substr(0, SIGNAL_NAME_LEN - 1);
+    uint32_t n = count.load(std::memory_order_acquire);
+    for (uint32_t i = 0; i < n; ++i) {
+        if (signals[i].can_id == can_id && name == signals[i].name) return static_cast<uint16_t>(i);
+    }
+    return INVALID_SIGNAL_ID;
+}
+
+const SignalInfo* SignalTable::info(uint16_t id) const {
+    if (id >= count.load(std::memory_order_acquire)) return nullptr;
+    return &signals[id];
+}
+
+bool intern_signals(FrameMap& frames, SignalTable& table) {
+    bool ok = true;
+    for (auto& [can_id, channels] : frames) {
+        for (auto& cfg : channels) {
+            cfg.signal_id = table.intern(can_id, cfg.name);
+            if (cfg.signal_id == INVALID_SIGNAL_ID) ok = false;
+        }
+    }
+    return ok;
+}
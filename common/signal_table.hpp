@@ -0,0 +1,89 @@
+#ifndef FSAE_SIGNAL_TABLE_HPP
+#define FSAE_SIGNAL_TABLE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+#include "config_types.hpp"
+
+inline constexpr std::size_t MAX_SIGNALS = 1024;
+inline constexpr std::size_t SIGNAL_NAME_LEN = 64;
+
+struct SignalInfo {
+    uint32_t can_id;
+    char name[SIGNAL_NAME_LEN];
+};
+
+struct LatestValue {
+    double value;
+    uint64_t timestamp_ns;
+    uint64_t updates;       // 0 = never received
+};
+
+// one signal's most recent value, written by can-reader under a per-slot seqlock
+struct LatestSlot {
+    std::atomic<uint32_t> seq{0};   // odd while an update is in progress
+    LatestValue data{};
+};
+
+// signal ID -> (CAN ID, name), published once by can-reader in shared memory
+// append-only: an ID never changes meaning, so consumers can cache lookups
+// also holds the latest value of every signal so late or lagging readers can catch up in O(1)
+struct SignalTable {
+    std::atomic<uint32_t> count{0};
+    SignalInfo signals[MAX_SIGNALS];
+    LatestSlot latest[MAX_SIGNALS];
+
+    // writer only: ID for the signal, appending it if new
+    // returns INVALID_SIGNAL_ID if the table is full
+    uint16_t intern(uint32_t can_id, std::string_view name);
+
+    // ID for the signal, or INVALID_SIGNAL_ID if it hasn't been published
+    uint16_t find(uint32_t can_id, std::string_view name) const;
+
+    // entry for an ID, or nullptr if it hasn't been published
+    const SignalInfo* info(uint16_t id) const;
+
+    // writer only: record a new value for the signal
+    void update(uint16_t id, double value, uint64_t timestamp_ns);
+
+    // lock-free read of a signal's latest value; false if it has never been received
+    bool read_latest(uint16_t id, LatestValue& out) const;
+};
+
+inline void SignalTable::update(uint16_t id, double value, uint64_t timestamp_ns) {
+    if (id >= MAX_SIGNALS) return;
+    LatestSlot& slot = latest[id];
+
+    uint32_t seq = slot.seq.load(std::memory_order_relaxed);
+    slot.seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.data.value = value;
+    slot.data.timestamp_ns = timestamp_ns;
+    slot.data.updates = slot.data.updates + 1;
+
+    slot.seq.store(seq + 2, std::memory_order_release);
+}
+
+inline bool SignalTable::read_latest(uint16_t id, LatestValue& out) const {
+    if (id >= MAX_SIGNALS) return false;
+    const LatestSlot& slot = latest[id];
+
+    // an update is a few stores long; the bound only matters if the writer died mid-update
+    for (int attempt = 0; attempt < 1000; ++attempt) {
+        uint32_t before = slot.seq.load(std::memory_order_acquire);
+        if (before & 1) continue;
+        memcpy(&out, &slot.data, sizeof(out));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) == before) return out.updates != 0;
+    }
+    return false;
+}
+
+// assign every channel its interned signal ID; returns false if the table overflowed
+bool intern_signals(FrameMap& frames, SignalTable& table);
+
+#endif
@@ -0,0 +1,103 @@
+#ifndef FSAE_SPILL_RING_HPP
+#define FSAE_SPILL_RING_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+#include "config_types.hpp"
+
+// a telemetry message together with its position in the telemetry queue
+struct SpillRecord {
+    uint64_t pos;
+    TelemetryMessage msg;
+};
+
+// where can-reader diverts queue items a lossless consumer hasn't reached yet, just before
+// pushing over them; unlike the broadcast queue it never overwrites, a full ring refuses the item
+// single producer (can-reader) and a single consumer: the consumer slot named by consumer()
+// records follow the ring object in the same allocation (see bytes_for / create)
+class alignas(64) SpillRing {
+public:
+    static std::size_t bytes_for(std::size_t capacity) {
+        return records_offset() + capacity * sizeof(SpillRecord);
+    }
+
+    // construct a ring in `memory`, which must be bytes_for(capacity) long and 64-byte aligned
+    // capacity must be a power of 2
+    static SpillRing* create(void* memory, std::size_t capacity) {
+        if (capacity == 0 || (capacity & (capacity - 1)) != 0) return nullptr;
+        return new (memory) SpillRing(capacity);
+    }
+
+    SpillRing(const SpillRing&) = delete;
+    SpillRing& operator=(const SpillRing&) = delete;
+
+    std::size_t capacity() const { return capacity_; }
+
+    // records waiting for the consumer
+    std::size_t size() const {
+        return write_idx_.load(std::memory_order_acquire) - read_idx_.load(std::memory_order_acquire);
+    }
+
+    // producer: false (and nothing stored) when the consumer hasn't made room
+    bool push(const SpillRecord& record) {
+        std::size_t idx = write_idx_.load(std::memory_order_relaxed);
+        if (idx - read_idx_.load(std::memory_order_acquire) >= capacity_) return false;
+        records()[idx & mask_] = record;
+        write_idx_.store(idx + 1, std::memory_order_release);
+        return true;
+    }
+
+    // producer: serve consumer slot `consumer` (-1 for nobody) from now on
+    // records queued for the previous one are dropped; only call once it has stopped reading
+    void retarget(int32_t consumer) {
+        consumer_.store(-1, std::memory_order_release);
+        read_idx_.store(write_idx_.load(std::memory_order_relaxed), std::memory_order_release);
+        consumer_.store(consumer, std::memory_order_release);
+    }
+
+    // consumer slot the ring is being filled for, -1 for nobody
+    int32_t consumer() const { return consumer_.load(std::memory_order_acquire); }
+
+    // consumer: hand over the records that continue from consumer_pos, in order
+    // records below consumer_pos (already read from the queue) are thrown away; stops at the first
+    // record past consumer_pos, which means the items in between are still in the queue or lost
+    // returns the number of records passed to callback
+    template <typename Callback>
+    std::size_t replay(std::size_t& consumer_pos, Callback callback) {
+        std::size_t idx = read_idx_.load(std::memory_order_relaxed);
+        std::size_t end = write_idx_.load(std::memory_order_acquire);
+        std::size_t replayed = 0;
+        for (; idx < end; ++idx) {
+            const SpillRecord& record = records()[idx & mask_];
+            if (record.pos > consumer_pos) break;
+            if (record.pos == consumer_pos) {
+                callback(record.msg);
+                ++consumer_pos;
+                ++replayed;
+            }
+        }
+        read_idx_.store(idx, std::memory_order_release);
+        return replayed;
+    }
+
+private:
+    explicit SpillRing(std::size_t capacity) : capacity_(capacity), mask_(capacity - 1) {}
+
+    static constexpr std::size_t records_offset() { return (sizeof(SpillRing) + 63) & ~std::size_t{63}; }
+
+    SpillRecord* records() const {
+        return reinterpret_cast<SpillRecord*>(reinterpret_cast<uintptr_t>(this) + records_offset());
+    }
+
+    const std::size_t capacity_;
+    const std::size_t mask_;
+    std::atomic<int32_t> consumer_{-1};
+
+    alignas(64) std::atomic<std::size_t> write_idx_{0};
+    alignas(64) std::atomic<std::size_t> read_idx_{0};
+};
+
+#endif
@@ -0,0 +1,44 @@
+#include "stats_segment.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <unistd.h>
+
+// slot owners that died without releasing leave their pid behind
+static bool pid_alive(int32_t pid) {
+    return pid > 0 && (kill(pid, 0) == 0 || errno != ESRCH);
+}
+
+ConsumerStats* claim_consumer_stats(StatsSegment& stats, const char* name, uint32_t flags) {
+    int32_t self = static_cast<int32_t>(getpid());
+    for (auto& slot : stats.consumers) {
+        int32_t owner = slot.pid.load(std::memory_order_acquire);
+        if (owner != 0 && pid_alive(owner)) continue;
+        if (!slot.pid.compare_exchange_strong(owner, self, std::memory_order_acq_rel)) continue;
+
+        std::size_t len = std::min(strlen(name), CONSUMER_NAME_LEN - 1);
+        memcpy(slot.name, name, len);
+        slot.name[len] = '\0';
+        slot.flags.store(flags, std::memory_order_relaxed);
+        slot.pressure.store(static_cast<uint32_t>(ConsumerPressure::OK), std::memory_order_relaxed);
+        slot.position.store(0, std::memory_order_relaxed);
+        slot.consumed.store(0, std::memory_order_relaxed);
+        slot.dropped.store(0, std::memory_order_relaxed);
+        slot.spilled.store(0, std::memory_order_relaxed);
+        slot.rx_to_consume.reset();
+        slot.queue_to_consume.reset();
+        slot.heartbeat_ns.store(monotonic_ns(), std::memory_order_release);
+        return &slot;
+    }
+    return nullptr;
+}
+
+bool consumer_alive(const ConsumerStats& slot) {
+    return pid_alive(slot.pid.load(std::memory_order_acquire));
+}
+
+void release_consumer_stats(ConsumerStats* slot) {
+    if (slot) slot->pid.store(0, std::memory_order_release);
+}
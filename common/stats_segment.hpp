@@ -0,0 +1,120 @@
+#ifndef FSAE_STATS_SEGMENT_HPP
+#define FSAE_STATS_SEGMENT_HPP
+
+#include <atomic>
+#include <cstdint>
+
+#include "config_types.hpp"
+#include "latency_histogram.hpp"
+
+// consumers that can report at once (data-logger, graphics-engine, queue_reader, ...)
+inline constexpr int MAX_CONSUMERS = 8;
+inline constexpr std::size_t CONSUMER_NAME_LEN = 16;
+
+// every counter has a single writing thread, so it is bumped with relaxed load + store
+// instead of a locked read-modify-write; readers (fsae-top) only ever see whole values
+inline void stat_add(std::atomic<uint64_t>& counter, uint64_t n = 1) {
+    counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+inline void stat_set(std::atomic<uint64_t>& value, uint64_t n) {
+    value.store(n, std::memory_order_relaxed);
+}
+
+inline constexpr std::size_t BUS_NAME_LEN = 16;
+
+// written by one can-reader bus thread; an empty interface marks an unused slot
+struct BusStats {
+    char interface[BUS_NAME_LEN];
+    std::atomic<uint64_t> heartbeat_ns;
+    std::atomic<uint64_t> frames;           // frames read from the socket
+    std::atomic<uint64_t> unknown_frames;   // frames with no configured signals
+    std::atomic<uint64_t> signals;          // messages pushed to the queue
+    std::atomic<uint64_t> parse_ns;         // total time spent decoding and publishing
+    std::atomic<uint64_t> socket_overflows;
+    std::atomic<uint64_t> filter_rejects;
+    std::atomic<uint64_t> config_swaps;     // decoder configs switched to since start
+    std::atomic<uint64_t> swap_latency_ns;  // last switch: published -> first used by the bus thread
+    std::atomic<uint64_t> compile_ns;       // last reload: DBC -> decoder build, on the main thread
+    std::atomic<uint64_t> suppressed[PUBLISH_MODES];   // decoded values a publish policy held back, by PublishMode
+};
+
+// heartbeat_ns is CLOCK_MONOTONIC at the last update, so a viewer can spot a stalled process
+struct ReaderStats {
+    std::atomic<int32_t> pid;
+    std::atomic<uint64_t> heartbeat_ns;
+    std::atomic<uint64_t> queue_write_idx;
+    std::atomic<uint64_t> decimated;        // low-priority values held back while a consumer was behind
+    std::atomic<uint64_t> spill_full;       // items a lossless consumer lost because the spill ring was full
+    LatencyHistogram rx_to_queue;           // shared by all bus threads, recorded with atomic adds
+    BusStats buses[MAX_BUSES];
+};
+
+// ConsumerStats::flags, set by the consumer when it claims its slot
+inline constexpr uint32_t CONSUMER_LOSSLESS = 1;    // wants items it falls behind on spilled, not dropped
+
+// how far behind can-reader last found a consumer, ConsumerStats::pressure
+enum class ConsumerPressure : uint32_t {
+    OK,
+    WARN,           // past backpressure.warn_lag
+    DECIMATE,       // past backpressure.decimate_lag; low-priority signals are being thinned out
+    SPILL,          // lossless and past backpressure.decimate_lag; overwritten items go to the spill ring
+    STALLED         // no heartbeat for backpressure.stale_ms; ignored until it reports again
+};
+
+// one per attached consumer; pid == 0 marks a free slot
+// the consumer reports position and heartbeat, can-reader reads them to decide how to react
+// when it falls behind and writes back pressure and spilled
+struct ConsumerStats {
+    std::atomic<int32_t> pid;
+    char name[CONSUMER_NAME_LEN];
+    std::atomic<uint32_t> flags;
+    std::atomic<uint32_t> pressure;         // ConsumerPressure
+    std::atomic<uint64_t> heartbeat_ns;
+    std::atomic<uint64_t> position;         // lag = ReaderStats::queue_write_idx - position
+    std::atomic<uint64_t> consumed;
+    std::atomic<uint64_t> dropped;
+    std::atomic<uint64_t> spilled;          // items can-reader copied to the spill ring for it
+    LatencyHistogram rx_to_consume;         // kernel RX -> taken from the queue
+    LatencyHistogram queue_to_consume;      // pushed -> taken from the queue
+};
+
+struct LoggerStats {
+    std::atomic<int32_t> pid;
+    std::atomic<uint64_t> heartbeat_ns;
+    std::atomic<uint64_t> bytes_written;
+    std::atomic<uint64_t> flushes;
+    std::atomic<uint64_t> lost;         // samples dropped because every arena was waiting on the disk
+    LatencyHistogram flush_time;
+    LatencyHistogram rx_to_disk;
+};
+
+struct RenderStats {
+    std::atomic<int32_t> pid;
+    std::atomic<uint64_t> heartbeat_ns;
+    std::atomic<uint64_t> frames;
+    LatencyHistogram frame_time;
+    LatencyHistogram consume_to_present;
+};
+
+// lives in /fsae_stats; whichever process starts first creates it and nobody removes it,
+// so counters survive restarts and fsae-top can attach at any time
+// all-zero is the valid initial state
+struct StatsSegment {
+    ReaderStats reader;
+    ConsumerStats consumers[MAX_CONSUMERS];
+    LoggerStats logger;
+    RenderStats render;
+};
+
+// take a free (or abandoned) consumer slot, reset it and tag it with this process, name and flags
+// returns nullptr when every slot is held by a live process
+ConsumerStats* claim_consumer_stats(StatsSegment& stats, const char* name, uint32_t flags = 0);
+
+// whether the process that claimed a slot is still running (slots of crashed owners keep their pid)
+bool consumer_alive(const ConsumerStats& slot);
+
+// hand a slot back on exit
+void release_consumer_stats(ConsumerStats* slot);
+
+#endif
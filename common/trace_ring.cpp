@@ -0,0 +1,45 @@
+#include "trace_ring.hpp"
+
+#include <chrono>
+
+void TraceRing::start(TraceFormatter formatter, void* ctx, FILE* out) {
+    if (running_.load(std::memory_order_relaxed)) return;
+    formatter_ = formatter;
+    ctx_ = ctx;
+    out_ = out;
+    running_.store(true, std::memory_order_relaxed);
+    thread_ = std::thread(&TraceRing::drain_loop, this);
+}
+
+void TraceRing::stop() {
+    if (!running_.exchange(false, std::memory_order_relaxed)) return;
+    thread_.join();
+    drain();
+}
+
+std::size_t TraceRing::drain() {
+    uint64_t head = head_.load(std::memory_order_acquire);
+    uint64_t tail = tail_.load(std::memory_order_relaxed);
+    std::size_t n = head - tail;
+
+    for (; tail < head; ++tail) {
+        formatter_(records_[tail & (CAPACITY - 1)], out_, ctx_);
+    }
+    tail_.store(tail, std::memory_order_release);
+
+    uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+    if (dropped != reported_drops_) {
+        fprintf(out_, "trace: %llu records dropped (ring full)\n",
+                static_cast<unsigned long long>(dropped - reported_drops_));
+        reported_drops_ = dropped;
+    }
+    if (n) fflush(out_);
+    return n;
+}
+
+void TraceRing::drain_loop() {
+    while (running_.load(std::memory_order_relaxed)) {
+        // idle or quiet: poll a few times a frame period, a full ring takes far longer to fill
+        if (drain() == 0) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+}
@@ -0,0 +1,97 @@
+#ifndef FSAE_TRACE_RING_HPP
+#define FSAE_TRACE_RING_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+
+#include "config_types.hpp"
+#include "latency_histogram.hpp"
+
+// fixed-size binary record; what the fields mean depends on the event, the formatter decides
+struct TraceRecord {
+    uint64_t time_ns;   // CLOCK_MONOTONIC
+    uint32_t event;
+    uint32_t id;
+    uint64_t arg;
+    double value;
+};
+
+// formats one record; runs on the drain thread only
+using TraceFormatter = void (*)(const TraceRecord& rec, FILE* out, void* ctx);
+
+// single-producer ring of TraceRecords drained by a background thread
+// emit() never blocks or formats: when the ring is full the record is counted and dropped
+class TraceRing {
+public:
+    static constexpr std::size_t CAPACITY = 8192;
+
+    TraceRing() = default;
+    ~TraceRing() { stop(); }
+
+    TraceRing(const TraceRing&) = delete;
+    TraceRing& operator=(const TraceRing&) = delete;
+
+    // start the drain thread, writing formatted records to out
+    void start(TraceFormatter formatter, void* ctx, FILE* out = stdout);
+
+    // drain what is left and join the thread
+    void stop();
+
+    void set_level(TraceLevel level) { level_.store(static_cast<uint8_t>(level), std::memory_order_relaxed); }
+
+    bool enabled(TraceLevel level) const {
+        return static_cast<uint8_t>(level) <= level_.load(std::memory_order_relaxed);
+    }
+
+    // hot path: one relaxed level check when disabled, a 32-byte store when enabled
+    void emit(TraceLevel level, uint32_t event, uint32_t id, uint64_t arg = 0, double value = 0.0) {
+        if (!enabled(level)) return;
+
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_cache_ >= CAPACITY) {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (head - tail_cache_ >= CAPACITY) {
+                dropped_.store(dropped_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                return;
+            }
+        }
+
+        TraceRecord& rec = records_[head & (CAPACITY - 1)];
+        rec.time_ns = monotonic_ns();
+        rec.event = event;
+        rec.id = id;
+        rec.arg = arg;
+        rec.value = value;
+        head_.store(head + 1, std::memory_order_release);
+    }
+
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    void drain_loop();
+
+    // format everything published so far; returns the number of records written
+    std::size_t drain();
+
+    TraceRecord records_[CAPACITY];
+
+    std::atomic<uint8_t> level_{static_cast<uint8_t>(TraceLevel::OFF)};
+
+    // producer side
+    alignas(64) std::atomic<uint64_t> head_{0};
+    uint64_t tail_cache_ = 0;
+    std::atomic<uint64_t> dropped_{0};
+
+    // drain side
+    alignas(64) std::atomic<uint64_t> tail_{0};
+    uint64_t reported_drops_ = 0;
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+    TraceFormatter formatter_ = nullptr;
+    void* ctx_ = nullptr;
+    FILE* out_ = nullptr;
+};
+
+#endif
@@ -1,2 +1,339 @@
 #include "compressor.hpp"
 
+#include <cmath>
+#include <cstring>
+
+static constexpr std::size_t SIGNAL_IDS = 1 << 16;
+
+static uint64_t zigzag(int64_t v) {
+    return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+}
+
+static int64_t unzigzag(uint64_t v) {
+    return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+}
+
+static void put_varint(std::vector<uint8_t>& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<uint8_t>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+static bool get_varint(const uint8_t*& p, const uint8_t* end, uint64_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 64 && p < end; shift += 7) {
+        uint8_t byte = *p++;
+        v |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+static void put_le(uint8_t* p, uint64_t v, int bytes) {
+    for (int i = 0; i < bytes; ++i) p[i] = static_cast<uint8_t>(v >> (8 * i));
+}
+
+static uint64_t get_le(const uint8_t* p, int bytes) {
+    uint64_t v = 0;
+    for (int i = 0; i < bytes; ++i) v |= static_cast<uint64_t>(p[i]) << (8 * i);
+    return v;
+}
+
+static uint64_t bits_of(double v) {
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    return bits;
+}
+
+static double double_of(uint64_t bits) {
+    double v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+// MSB-first bit stream appended to a byte vector
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<uint8_t>& out) : out_(out) {}
+
+    // the low n bits of bits, 1 <= n <= 64
+    void put(uint64_t bits, int n) {
+        if (n > 32) {
+            put(bits >> 32, n - 32);
+            n = 32;
+        }
+        acc_ = (acc_ << n) | (bits & ((uint64_t{1} << n) - 1));
+        fill_ += n;
+        while (fill_ >= 8) {
+            fill_ -= 8;
+            out_.push_back(static_cast<uint8_t>(acc_ >> fill_));
+        }
+    }
+
+    // pad the last byte with zeros
+    void finish() {
+        if (fill_) out_.push_back(static_cast<uint8_t>(acc_ << (8 - fill_)));
+        fill_ = 0;
+    }
+
+private:
+    std::vector<uint8_t>& out_;
+    uint64_t acc_ = 0;
+    int fill_ = 0;
+};
+
+class BitReader {
+public:
+    BitReader(const uint8_t* p, const uint8_t* end) : p_(p), end_(end) {}
+
+    uint64_t get(int n) {
+        if (n > 32) {
+            uint64_t high = get(n - 32);
+            return (high << 32) | get(32);
+        }
+        while (fill_ < n) {
+            if (p_ == end_) {
+                bad_ = true;
+                return 0;
+            }
+            acc_ = (acc_ << 8) | *p_++;
+            fill_ += 8;
+        }
+        fill_ -= n;
+        return (acc_ >> fill_) & ((uint64_t{1} << n) - 1);
+    }
+
+    bool bad() const { return bad_; }
+
+    // first byte after the stream (the padding of the last one is skipped)
+    const uint8_t* pos() const { return p_; }
+
+private:
+    const uint8_t* p_;
+    const uint8_t* end_;
+    uint64_t acc_ = 0;
+    int fill_ = 0;
+    bool bad_ = false;
+};
+
+// 1 + index of the first step every value is an exact multiple of, 0 if none is
+static uint8_t pick_value_mode(const std::vector<double>& values) {
+    for (int k = 0; k < LOG_VALUE_STEP_COUNT; ++k) {
+        double step = LOG_VALUE_STEPS[k];
+        bool fits = true;
+        for (double v : values) {
+            double n = std::nearbyint(v / step);
+            // the decoder rebuilds n * step from an integer n, which has to give back the very
+            // same bits (so -0.0 and NaN go to the XOR mode)
+            if (!(std::fabs(n) < 9007199254740992.0) ||
+                bits_of(static_cast<double>(static_cast<int64_t>(n)) * step) != bits_of(v)) {
+                fits = false;
+                break;
+            }
+        }
+        if (fits) return static_cast<uint8_t>(k + 1);
+    }
+    return 0;
+}
+
+static void encode_times(std::vector<uint8_t>& out, const std::vector<int64_t>& times, int64_t base) {
+    put_varint(out, zigzag(times[0] - base));
+    int64_t delta = 0;
+    for (std::size_t i = 1; i < times.size(); ++i) {
+        int64_t d = times[i] - times[i - 1];
+        put_varint(out, zigzag(d - delta));
+        delta = d;
+    }
+}
+
+static void encode_scaled(std::vector<uint8_t>& out, const std::vector<double>& values, double step) {
+    int64_t prev = 0;
+    for (double v : values) {
+        auto n = static_cast<int64_t>(std::nearbyint(v / step));
+        put_varint(out, zigzag(n - prev));
+        prev = n;
+    }
+}
+
+// Gorilla: identical values cost one bit, values whose changed bits fit the previous window
+// cost two bits plus the window, anything else 13 bits of window description plus the bits
+static void encode_xor(std::vector<uint8_t>& out, const std::vector<double>& values) {
+    BitWriter bits(out);
+    uint64_t prev = bits_of(values[0]);
+    bits.put(prev, 64);
+    int lead = -1, trail = 0;
+    for (std::size_t i = 1; i < values.size(); ++i) {
+        uint64_t cur = bits_of(values[i]);
+        uint64_t x = cur ^ prev;
+        prev = cur;
+        if (x == 0) {
+            bits.put(0, 1);
+            continue;
+        }
+        int l = __builtin_clzll(x);
+        int t = __builtin_ctzll(x);
+        if (l > 31) l = 31;
+        if (lead >= 0 && l >= lead && t >= trail) {
+            bits.put(0b10, 2);
+            bits.put(x >> trail, 64 - lead - trail);
+        } else {
+            int width = 64 - l - t;
+            bits.put(0b11, 2);
+            bits.put(static_cast<uint64_t>(l), 5);
+            bits.put(static_cast<uint64_t>(width - 1), 6);
+            bits.put(x >> t, width);
+            lead = l;
+            trail = t;
+        }
+    }
+    bits.finish();
+}
+
+BlockEncoder::BlockEncoder() : column_of_(SIGNAL_IDS, 0) {}
+
+BlockEncoder::Column& BlockEncoder::column_for(uint32_t can_id, uint16_t signal_id) {
+    uint32_t index = column_of_[signal_id];
+    if (index && columns_[index - 1].can_id == can_id) return columns_[index - 1];
+
+    // a signal ID seen under another CAN ID (only if can-reader's signal table was full)
+    for (std::size_t i = 0; index && i < live_columns_; ++i) {
+        if (columns_[i].signal_id == signal_id && columns_[i].can_id == can_id) return columns_[i];
+    }
+
+    if (live_columns_ == columns_.size()) columns_.emplace_back();
+    Column& column = columns_[live_columns_++];
+    column.can_id = can_id;
+    column.signal_id = signal_id;
+    if (!index) column_of_[signal_id] = static_cast<uint32_t>(live_columns_);
+    return column;
+}
+
+void BlockEncoder::add(const LogSample& sample) {
+    if (samples_ == 0 || sample.time_us < base_time_us_) base_time_us_ = sample.time_us;
+    Column& column = column_for(sample.can_id, sample.signal_id);
+    column.times.push_back(sample.time_us);
+    column.values.push_back(sample.value);
+    ++samples_;
+}
+
+std::size_t BlockEncoder::finish_block(std::vector<uint8_t>& out) {
+    if (samples_ == 0) return 0;
+
+    std::size_t start = out.size();
+    out.resize(start + LOG_BLOCK_HEADER_SIZE);
+    for (std::size_t c = 0; c < live_columns_; ++c) {
+        Column& column = columns_[c];
+        put_varint(out, column.signal_id);
+        put_varint(out, column.can_id);
+        put_varint(out, column.times.size());
+        uint8_t mode = pick_value_mode(column.values);
+        out.push_back(mode);
+        encode_times(out, column.times, base_time_us_);
+        if (mode) encode_scaled(out, column.values, LOG_VALUE_STEPS[mode - 1]);
+        else encode_xor(out, column.values);
+
+        column_of_[column.signal_id] = 0;
+        column.times.clear();
+        column.values.clear();
+    }
+
+    uint8_t* header = out.data() + start;
+    put_le(header, LOG_BLOCK_MAGIC, 4);
+    put_le(header + 4, out.size() - start - LOG_BLOCK_HEADER_SIZE, 4);
+    put_le(header + 8, samples_, 4);
+    put_le(header + 12, live_columns_, 4);
+    put_le(header + 16, static_cast<uint64_t>(base_time_us_), 8);
+
+    live_columns_ = 0;
+    samples_ = 0;
+    return out.size() - start;
+}
+
+std::size_t decode_block(const uint8_t* data, std::size_t len, std::vector<LogSample>& out) {
+    if (len < LOG_BLOCK_HEADER_SIZE || get_le(data, 4) != LOG_BLOCK_MAGIC) return 0;
+    std::size_t body_bytes = get_le(data + 4, 4);
+    std::size_t sample_count = get_le(data + 8, 4);
+    std::size_t channel_count = get_le(data + 12, 4);
+    auto base = static_cast<int64_t>(get_le(data + 16, 8));
+    if (body_bytes > len - LOG_BLOCK_HEADER_SIZE) return 0;
+
+    const uint8_t* p = data + LOG_BLOCK_HEADER_SIZE;
+    const uint8_t* end = p + body_bytes;
+    std::size_t first = out.size();
+    std::size_t remaining = sample_count;
+
+    for (std::size_t c = 0; c < channel_count; ++c) {
+        uint64_t signal_id, can_id, count, v;
+        if (!get_varint(p, end, signal_id) || !get_varint(p, end, can_id) || !get_varint(p, end, count) ||
+            count == 0 || count > remaining || signal_id >= SIGNAL_IDS || p == end) {
+            out.resize(first);
+            return 0;
+        }
+        remaining -= count;
+        uint8_t mode = *p++;
+        if (mode > LOG_VALUE_STEP_COUNT) {
+            out.resize(first);
+            return 0;
+        }
+
+        std::size_t column = out.size();
+        int64_t t = base, delta = 0;
+        for (uint64_t i = 0; i < count; ++i) {
+            if (!get_varint(p, end, v)) {
+                out.resize(first);
+                return 0;
+            }
+            if (i == 0) t += unzigzag(v);
+            else {
+                delta += unzigzag(v);
+                t += delta;
+            }
+            out.push_back(LogSample{t, static_cast<uint32_t>(can_id), static_cast<uint16_t>(signal_id), 0.0});
+        }
+
+        if (mode) {
+            double step = LOG_VALUE_STEPS[mode - 1];
+            int64_t n = 0;
+            for (uint64_t i = 0; i < count; ++i) {
+                if (!get_varint(p, end, v)) {
+                    out.resize(first);
+                    return 0;
+                }
+                n += unzigzag(v);
+                out[column + i].value = static_cast<double>(n) * step;
+            }
+            continue;
+        }
+
+        BitReader bits(p, end);
+        uint64_t prev = bits.get(64);
+        out[column].value = double_of(prev);
+        int lead = 0, trail = 0;
+        bool bad = false;
+        for (uint64_t i = 1; i < count && !bad; ++i) {
+            if (bits.get(1)) {
+                if (bits.get(1)) {
+                    lead = static_cast<int>(bits.get(5));
+                    trail = 64 - lead - (static_cast<int>(bits.get(6)) + 1);
+                    if (trail < 0) bad = true;
+                }
+                if (!bad) prev ^= bits.get(64 - lead - trail) << trail;
+            }
+            out[column + i].value = double_of(prev);
+            bad |= bits.bad();
+        }
+        if (bad || bits.bad()) {
+            out.resize(first);
+            return 0;
+        }
+        p = bits.pos();
+    }
+
+    if (p != end || remaining != 0) {
+        out.resize(first);
+        return 0;
+    }
+    return LOG_BLOCK_HEADER_SIZE + body_bytes;
+}
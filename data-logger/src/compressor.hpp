@@ -1,8 +1,74 @@
 #ifndef FSAE_COMPRESSOR_HPP
 #define FSAE_COMPRESSOR_HPP
 
-#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
 
-// compress data
+// one logged value; time_us is CLOCK_REALTIME microseconds at kernel RX
+struct LogSample {
+    int64_t time_us;
+    uint32_t can_id;
+    uint16_t signal_id;
+    double value;
+};
+
+// a log file is LOG_FILE_MAGIC followed by blocks, each self-contained:
+//
+// | magic (u32) | body_bytes (u32) | sample_count (u32) | channel_count (u32) | base_time_us (i64) |
+// then per channel (a signal ID + CAN ID pair), in order of first appearance in the block:
+// | signal_id, can_id, count (varints) | value mode (u8) | times | values |
+//
+// times: zigzag varints of first - base_time_us, then of the first delta, then delta-of-deltas
+// values, by mode: 0 = Gorilla XOR bitstream (first value raw, then XOR with the previous,
+// padded to a byte); k > 0 = every value is an exact multiple n * LOG_VALUE_STEPS[k - 1], stored
+// as zigzag varints of the first n and then of the deltas
+// all fixed-width fields are little-endian
+inline constexpr char LOG_FILE_MAGIC[8] = {'F', 'S', 'A', 'E', 'L', 'O', 'G', '2'};
+inline constexpr uint32_t LOG_BLOCK_MAGIC = 0x314B4C42;    // "BLK1"
+inline constexpr std::size_t LOG_BLOCK_HEADER_SIZE = 24;
+
+// DBC scales tried for the integer value mode, coarsest first
+inline constexpr double LOG_VALUE_STEPS[] = {1.0, 0.5, 0.25, 0.125, 0.1, 0.05, 0.02, 0.01,
+                                             0.005, 0.002, 0.001, 0.0001, 0.00001};
+inline constexpr int LOG_VALUE_STEP_COUNT = sizeof(LOG_VALUE_STEPS) / sizeof(LOG_VALUE_STEPS[0]);
+
+// collects samples and encodes them as one columnar block: grouped by channel, so each column
+// holds one signal's steady timestamps and slowly moving values, which is what the
+// delta-of-delta, XOR and varint encodings need to shrink them
+// column buffers are kept between blocks, so a warmed-up encoder doesn't allocate
+class BlockEncoder {
+public:
+    BlockEncoder();
+
+    void add(const LogSample& sample);
+
+    // samples added since the last finish_block
+    std::size_t size() const { return samples_; }
+
+    // encode every sample added since the last call as one block appended to out, and start
+    // a new block; returns the bytes appended (0 if the block was empty)
+    std::size_t finish_block(std::vector<uint8_t>& out);
+
+private:
+    struct Column {
+        uint32_t can_id;
+        uint16_t signal_id;
+        std::vector<int64_t> times;
+        std::vector<double> values;
+    };
+
+    Column& column_for(uint32_t can_id, uint16_t signal_id);
+
+    std::vector<Column> columns_;
+    std::size_t live_columns_ = 0;      // columns_[0 .. live_columns_) are in the current block
+    std::vector<uint32_t> column_of_;   // signal ID -> 1 + column index in the current block, 0 = none
+    std::size_t samples_ = 0;
+    int64_t base_time_us_ = 0;
+};
+
+// decode the block at data, appending its samples channel by channel
+// returns the bytes the block takes up, or 0 if it is malformed or runs past len
+std::size_t decode_block(const uint8_t* data, std::size_t len, std::vector<LogSample>& out);
 
 #endif
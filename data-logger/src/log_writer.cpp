@@ -1,10 +1,16 @@
 #include "log_writer.hpp"
 
+#include <algorithm>
+#include <cerrno>
 #include <chrono>
 #include <ctime>
 #include <cstdio>
+#include <fcntl.h>
 #include <string>
 #include <sys/stat.h>
+#include <unistd.h>
+
+#include "latency_histogram.hpp"
 
 static constexpr const char* LOG_DIR = "/tmp/fsae-logs";
 
@@ -18,33 +24,183 @@ static std::string make_log_path() {
     return std::string(LOG_DIR) + "/" + buf;
 }
 
-LogWriter::LogWriter() {
-    mkdir(LOG_DIR, 0755);
-    std::string path = make_log_path();
-    file_ = fopen(path.c_str(), "wb");
-    if (!file_) {
-        std::perror("Failed to open log file");
+static int64_t wall_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+LogWriter::LogWriter(LoggerStats& stats, const SignalTable* signals, const std::string& path, bool direct)
+    : stats_(stats), signals_(signals) {
+    std::string file = path;
+    if (file.empty()) {
+        mkdir(LOG_DIR, 0755);
+        file = make_log_path();
     }
-    else {
-        printf("Logging to %s\n", path.c_str());
+    if (direct) {
+        direct_ = std::make_unique<UringWriter>(file, &stats_.flush_time);
+        if (!direct_->is_open()) {
+            direct_.reset();
+            printf("io_uring with O_DIRECT isn't available here, using buffered writes\n");
+        }
     }
+    if (!direct_) {
+        fd_ = open(file.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd_ < 0) {
+            std::perror("Failed to open log file");
+            return;
+        }
+    }
+    printf("Logging to %s%s\n", file.c_str(), direct_ ? " (O_DIRECT, io_uring)" : "");
+
+    for (Arena& a : arenas_) a.samples.reserve(BLOCK_SAMPLES);
+    out_.reserve(2 * LOG_WRITE_ALIGN);
+    out_.insert(out_.end(), LOG_FILE_MAGIC, LOG_FILE_MAGIC + sizeof(LOG_FILE_MAGIC));
+    running_.store(true, std::memory_order_relaxed);
+    thread_ = std::thread(&LogWriter::io_loop, this);
 }
 
 LogWriter::~LogWriter() {
-    if (file_) {
-        fflush(file_);
-        fclose(file_);
+    if (!is_open()) return;
+    flush(true);
+    if (running_.exchange(false, std::memory_order_relaxed)) thread_.join();
+    drain();
+    write_out(true);
+    if (direct_) direct_->close();
+    else close(fd_);
+}
+
+LogWriter::Arena* LogWriter::open_arena() {
+    uint64_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) >= LOG_ARENAS) return nullptr;
+    return &arenas_[head % LOG_ARENAS];
+}
+
+void LogWriter::hand_over() {
+    head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void LogWriter::write(uint32_t can_id, uint16_t signal_id, double value) {
+    staged_.push_back(LogSample{wall_us(), can_id, signal_id, value});
+    staged_ingest_.push_back(monotonic_ns());
+    write_staged(0);
+}
+
+void LogWriter::stage(const TelemetryMessage* msgs, std::size_t count) {
+    // ingest_ns is CLOCK_MONOTONIC at kernel RX: carry its age over to the wall clock
+    int64_t wall = wall_us();
+    uint64_t mono = monotonic_ns();
+
+    for (std::size_t i = 0; i < count; ++i) {
+        uint64_t ingest = msgs[i].ingest_ns;
+        bool valid = ingest && ingest <= mono;
+        int64_t age_us = valid ? static_cast<int64_t>((mono - ingest) / 1000) : 0;
+        const SignalInfo* info = signals_ ? signals_->info(msgs[i].signal_id) : nullptr;
+        staged_.push_back(LogSample{wall - age_us, info ? info->can_id : 0, msgs[i].signal_id, msgs[i].value});
+        staged_ingest_.push_back(valid ? ingest : mono);
     }
 }
 
-void LogWriter::write(uint32_t can_id, double value) {
-    if (!file_) return;
-    auto now = std::chrono::system_clock::now();
-    LogEntry entry;
-    entry.timestamp_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-        now.time_since_epoch()).count();
-    entry.can_id = can_id;
-    entry._pad   = 0;
-    entry.value  = value;
-    fwrite(&entry, sizeof(entry), 1, file_);
+void LogWriter::write_staged(std::size_t skip) {
+    std::size_t n = staged_.size();
+    for (std::size_t i = skip; is_open() && i < n;) {
+        Arena* a = open_arena();
+        if (!a) {
+            // the card has fallen a whole ring of arenas behind: losing samples here beats
+            // letting the queue lap the logger, which would lose them anyway and stall replay
+            lost_ += n - i;
+            stat_set(stats_.lost, lost_);
+            break;
+        }
+        if (a->samples.empty()) {
+            a->opened_ns = monotonic_ns();
+            a->oldest_ingest_ns = staged_ingest_[i];
+        }
+        std::size_t take = std::min(n - i, BLOCK_SAMPLES - a->samples.size());
+        a->samples.insert(a->samples.end(), staged_.begin() + static_cast<long>(i),
+                          staged_.begin() + static_cast<long>(i + take));
+        i += take;
+        if (a->samples.size() >= BLOCK_SAMPLES) hand_over();
+    }
+    staged_.clear();
+    staged_ingest_.clear();
+}
+
+void LogWriter::flush(bool force) {
+    if (!is_open()) return;
+    Arena* a = open_arena();
+    if (a && !a->samples.empty() &&
+        (force || monotonic_ns() - a->opened_ns >= static_cast<uint64_t>(BLOCK_MAX_AGE_US) * 1000)) {
+        hand_over();
+    }
+}
+
+std::size_t LogWriter::drain() {
+    uint64_t head = head_.load(std::memory_order_acquire);
+    uint64_t tail = tail_.load(std::memory_order_relaxed);
+    std::size_t n = head - tail;
+
+    for (; tail < head; ++tail) {
+        Arena& a = arenas_[tail % LOG_ARENAS];
+        for (const LogSample& sample : a.samples) encoder_.add(sample);
+        if (!out_oldest_ingest_ns_) out_oldest_ingest_ns_ = a.oldest_ingest_ns;
+        encoder_.finish_block(out_);
+        a.samples.clear();
+        // free each arena as soon as it is encoded, the consume thread may be waiting for one
+        tail_.store(tail + 1, std::memory_order_release);
+    }
+    return n;
+}
+
+void LogWriter::write_out(bool all) {
+    std::size_t n = out_.size();
+    if (!all) {
+        uint64_t end = (file_pos_ + n) & ~static_cast<uint64_t>(LOG_WRITE_ALIGN - 1);
+        if (end <= file_pos_) return;
+        n = end - file_pos_;
+    }
+    if (n == 0) return;
+
+    uint64_t start = monotonic_ns();
+    std::size_t done = 0;
+    if (direct_) {
+        // only submitted: flush_time is recorded per write, on completion
+        direct_->append(out_.data(), n);
+        if (all) direct_->sync_tail();
+        done = n;
+    }
+    while (done < n) {
+        ssize_t w = ::write(fd_, out_.data() + done, n - done);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) {
+            // a full or failing card: what didn't make it is dropped, logging carries on
+            if (!write_failed_) std::perror("Failed to write log file");
+            write_failed_ = true;
+            break;
+        }
+        done += static_cast<std::size_t>(w);
+    }
+    uint64_t end = monotonic_ns();
+
+    if (!direct_) stats_.flush_time.record_since(start, end);
+    // (direct writes count as on disk once submitted, at most DIRECT_BUFFERS writes early)
+    if (n == out_.size() && out_oldest_ingest_ns_) {
+        stats_.rx_to_disk.record_since(out_oldest_ingest_ns_, end);
+        out_oldest_ingest_ns_ = 0;
+    }
+    stat_add(stats_.flushes);
+    stat_add(stats_.bytes_written, done);
+    file_pos_ += done;
+    out_.erase(out_.begin(), out_.begin() + static_cast<long>(n));
+}
+
+void LogWriter::io_loop() {
+    while (running_.load(std::memory_order_relaxed)) {
+        std::size_t taken = drain();
+        if (direct_) direct_->reap();
+        // with more arenas already waiting, keep to whole aligned chunks; once caught up,
+        // everything encoded is due (arenas are only handed over full or old)
+        bool backlog = head_.load(std::memory_order_acquire) != tail_.load(std::memory_order_relaxed);
+        write_out(!backlog);
+        if (taken == 0) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
 }
@@ -1,32 +1,107 @@
 #ifndef FSAE_LOG_WRITER_HPP
 #define FSAE_LOG_WRITER_HPP
 
+#include <atomic>
 #include <cstdint>
-#include <cstdio>
-
-// Binary log entry layout (24 bytes):
-// | timestamp_ms (int64) | can_id (uint32) | _pad (uint32) | value (double) |
-struct LogEntry {
-    int64_t  timestamp_ms;
-    uint32_t can_id;
-    uint32_t _pad;
-    double   value;
-};
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "compressor.hpp"
+#include "config_types.hpp"
+#include "signal_table.hpp"
+#include "stats_segment.hpp"
+#include "uring_writer.hpp"
+
+// samples per block once the bus is busy; at lower rates BLOCK_MAX_AGE_US closes blocks first
+inline constexpr std::size_t BLOCK_SAMPLES = 16384;
+inline constexpr int64_t BLOCK_MAX_AGE_US = 500000;
+
+// arenas of BLOCK_SAMPLES between the consume and I/O threads: about 3 s of a full bus can wait
+// on a stalled card before samples are lost
+inline constexpr std::size_t LOG_ARENAS = 8;
+
+// writes go out in multiples of this (by file offset) while the I/O thread has a backlog
+inline constexpr std::size_t LOG_WRITE_ALIGN = 64 * 1024;
 
+// writes the columnar block format of compressor.hpp without ever blocking the caller on disk
+// the consume thread (the caller) only copies samples into preallocated arenas, one block each,
+// and hands an arena over once it holds BLOCK_SAMPLES or its oldest sample is BLOCK_MAX_AGE_US
+// old; a background I/O thread encodes handed-over arenas and writes them
+// arenas pass through a single-producer ring like TraceRing's: when every arena is waiting on the
+// disk, new samples are counted in LoggerStats::lost and dropped rather than waited for
 class LogWriter {
 public:
-    LogWriter();
+    // opens path (by default a new timestamped file in /tmp/fsae-logs) and starts the I/O
+    // thread, which reports into stats; direct writes through UringWriter where the kernel and
+    // filesystem allow it, and through the page cache otherwise
+    // messages carry only a signal ID: samples get their CAN ID from signals (0 without it)
+    LogWriter(LoggerStats& stats, const SignalTable* signals, const std::string& path = "", bool direct = false);
     ~LogWriter();
 
     LogWriter(const LogWriter&) = delete;
     LogWriter& operator=(const LogWriter&) = delete;
 
-    bool is_open() const { return file_ != nullptr; }
-    void write(uint32_t can_id, double value);
-    void flush() { if (file_) fflush(file_); }
+    bool is_open() const { return fd_ >= 0 || direct_; }
+
+    // whether writes bypass the page cache
+    bool direct() const { return direct_ != nullptr; }
+    void write(uint32_t can_id, uint16_t signal_id, double value);
+
+    // hand the open arena to the I/O thread if it is due (or always, with force)
+    void flush(bool force = false);
+
+    // convert a run of messages to samples, each stamped with its own receive time
+    void stage(const TelemetryMessage* msgs, std::size_t count);
+
+    // move staged samples into the open arena, discarding the first `skip` (overwritten in the
+    // queue); hands the arena over each time it fills
+    void write_staged(std::size_t skip);
+
+    // samples dropped because no arena was free
+    uint64_t lost() const { return lost_; }
 
 private:
-    FILE* file_ = nullptr;
+    struct Arena {
+        std::vector<LogSample> samples;     // reserved to BLOCK_SAMPLES, never reallocated
+        uint64_t opened_ns = 0;             // monotonic time of the first sample
+        uint64_t oldest_ingest_ns = 0;      // kernel RX of the first sample, for rx_to_disk
+    };
+
+    // the arena the consume thread is filling, nullptr while all are queued for the I/O thread
+    Arena* open_arena();
+    void hand_over();
+
+    void io_loop();
+
+    // encode and append every handed-over arena to out_; returns the number taken
+    std::size_t drain();
+
+    // write out_ up to the last LOG_WRITE_ALIGN boundary, or all of it
+    void write_out(bool all);
+
+    int fd_ = -1;                           // buffered writes
+    std::unique_ptr<UringWriter> direct_;   // or O_DIRECT ones
+    LoggerStats& stats_;
+    const SignalTable* signals_;
+    Arena arenas_[LOG_ARENAS];
+
+    // consume side
+    alignas(64) std::atomic<uint64_t> head_{0};     // arenas handed over
+    std::vector<LogSample> staged_;
+    std::vector<uint64_t> staged_ingest_;
+    uint64_t lost_ = 0;
+
+    // I/O side
+    alignas(64) std::atomic<uint64_t> tail_{0};     // arenas encoded and free again
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+    BlockEncoder encoder_;
+    std::vector<uint8_t> out_;                      // encoded, not yet written
+    uint64_t out_oldest_ingest_ns_ = 0;             // RX of the oldest sample in out_, 0 = none
+    uint64_t file_pos_ = 0;
+    bool write_failed_ = false;
 };
 
 #endif
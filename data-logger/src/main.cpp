@@ -1,9 +1,15 @@
 #include <csignal>
 #include <cstdio>
+#include <cstring>
+#include <chrono>
 #include <unistd.h>
 
 #include "shared_memory.hpp"
 #include "log_writer.hpp"
+#include "latency_histogram.hpp"
+
+// max messages taken from the queue per batch
+static constexpr std::size_t LOG_BATCH = 4096;
 
 static volatile sig_atomic_t running = 1;
 
@@ -11,7 +17,11 @@ static void signal_handler(int) {
     running = 0;
 }
 
-int main() {
+// usage: data-logger [--direct]
+// --direct writes with O_DIRECT through io_uring where supported, bypassing the page cache
+int main(int argc, char* argv[]) {
+    bool direct = argc > 1 && std::strcmp(argv[1], "--direct") == 0;
+
     struct sigaction sa{};
     sa.sa_handler = signal_handler;
     sigaction(SIGINT, &sa, nullptr);
@@ -23,27 +33,134 @@ int main() {
         return 1;
     }
 
-    LogWriter writer;
+    // can-reader creates it before the queue; without it samples are logged with CAN ID 0
+    SignalTable* signals = open_signal_table(false);
+    if (!signals) std::perror("Failed to open shared memory signal table");
+
+    // metrics are best effort: without the segment they go to a private copy
+    static StatsSegment local_stats;
+    StatsSegment* shared_stats = open_stats_segment();
+    if (!shared_stats) std::perror("Failed to open stats segment");
+    StatsSegment& stats = shared_stats ? *shared_stats : local_stats;
+    // lossless: can-reader spills what we fall behind on instead of letting it be overwritten
+    ConsumerStats* consumer = claim_consumer_stats(stats, "data-logger", CONSUMER_LOSSLESS);
+    int32_t slot = shared_stats && consumer ? static_cast<int32_t>(consumer - shared_stats->consumers) : -1;
+    if (!consumer) consumer = &local_stats.consumers[0];
+    LoggerStats& logger = stats.logger;
+    logger.pid.store(static_cast<int32_t>(getpid()), std::memory_order_relaxed);
+    logger.flush_time.reset();
+    logger.rx_to_disk.reset();
+
+    // disk writes happen on the writer's own thread, this one only consumes
+    LogWriter writer(logger, signals, "", direct);
     if (!writer.is_open()) {
+        logger.pid.store(0, std::memory_order_relaxed);
+        release_consumer_stats(consumer);
+        if (shared_stats) close_stats_segment(shared_stats);
+        if (signals) close_signal_table(signals, false);
         close_shared_queue(queue, false);
         return 1;
     }
 
     std::size_t pos = queue->current_pos();
+    stat_set(consumer->position, pos);
     printf("Data logger started. waiting for telemetry..\n");
 
+    // only there while can-reader has spilling configured; looked for again once a second
+    SpillRing* spill = slot >= 0 ? open_spill_ring(false) : nullptr;
+    uint64_t spill_retry_ns = monotonic_ns();
+
+    std::size_t dropped = 0;
+
+    // kernel RX and queue push -> taken from the queue, per message (the writer's thread records
+    // RX -> on disk)
+    LatencyHistogram& rx_to_consume = consumer->rx_to_consume;
+    LatencyHistogram& queue_to_consume = consumer->queue_to_consume;
+    static uint64_t ingest[LOG_BATCH];
+    static uint64_t queued[LOG_BATCH];
     while (running) {
-        std::size_t prev = pos;
-        queue->consume(pos, [&](const TelemetryMessage& msg) {
-            writer.write(msg.can_id, msg.value);
-        });
-        if (pos == prev) {
-            usleep(1000); // 1ms sleep when idle
-        } else {
+        // items can-reader spilled before overwriting them come first, in queue order
+        bool spilling = spill && spill->consumer() == slot;
+        if (spilling) {
+            std::size_t replayed = spill->replay(pos, [&](const TelemetryMessage& msg) { writer.stage(&msg, 1); });
+            if (replayed) {
+                writer.write_staged(0);
+                writer.flush();
+                stat_add(consumer->consumed, replayed);
+                stat_set(consumer->position, pos);
+            }
+        }
+
+        // process whole contiguous runs straight out of the ring
+        auto batch = queue->peek_batch(pos, LOG_BATCH);
+        if (batch.size() == 0) {
+            // sleep on the queue's futex until can-reader pushes; timeout keeps shutdown responsive
+            queue->wait_for_data(pos, std::chrono::milliseconds(100));
+            uint64_t now = monotonic_ns();
+            stat_set(consumer->heartbeat_ns, now);
+            // a quiet bus still gets its open block on disk within BLOCK_MAX_AGE_US
             writer.flush();
+            if (!spill && slot >= 0 && now - spill_retry_ns > 1000000000) {
+                spill = open_spill_ring(false);
+                spill_retry_ns = now;
+            }
+            continue;
+        }
+
+        uint64_t now = monotonic_ns();
+        std::size_t n = 0;
+        for (std::size_t i = 0; i < batch.first_len; ++i, ++n) {
+            ingest[n] = batch.first[i].ingest_ns;
+            queued[n] = batch.first[i].queued_ns();
+        }
+        for (std::size_t i = 0; i < batch.second_len; ++i, ++n) {
+            ingest[n] = batch.second[i].ingest_ns;
+            queued[n] = batch.second[i].queued_ns();
         }
+
+        writer.stage(batch.first, batch.first_len);
+        writer.stage(batch.second, batch.second_len);
+        std::size_t overwritten = queue->commit(pos, batch);
+        if (overwritten && spilling) {
+            // the overwritten front of the batch went to the spill ring first: start over from it
+            writer.write_staged(n);
+            pos = batch.begin;
+            dropped += batch.dropped;
+            stat_add(consumer->dropped, batch.dropped);
+            continue;
+        }
+        // copies into the writer's arena only, never waits on the disk
+        writer.write_staged(overwritten);
+        writer.flush();
+
+        // stamps of overwritten items may be torn, only the rest are recorded
+        for (std::size_t i = overwritten; i < n; ++i) {
+            rx_to_consume.record_since(ingest[i], now);
+            queue_to_consume.record_since(queued[i], now);
+        }
+
+        dropped += batch.dropped + overwritten;
+
+        uint64_t done = monotonic_ns();
+        stat_set(logger.heartbeat_ns, done);
+        stat_set(consumer->position, pos);
+        stat_add(consumer->consumed, n - overwritten);
+        stat_add(consumer->dropped, batch.dropped + overwritten);
+        stat_set(consumer->heartbeat_ns, done);
     }
 
+    if (dropped) printf("Data logger fell behind and dropped %zu messages\n", dropped);
+    if (writer.lost())
+        printf("The SD card fell behind and %llu samples were lost\n", static_cast<unsigned long long>(writer.lost()));
+    print_latency("rx->consume", rx_to_consume);
+    print_latency("queue->consume", queue_to_consume);
+    print_latency("rx->disk", logger.rx_to_disk);
+
+    logger.pid.store(0, std::memory_order_relaxed);
+    release_consumer_stats(consumer);
+    if (spill) close_spill_ring(spill, false);
+    if (shared_stats) close_stats_segment(shared_stats);
+    if (signals) close_signal_table(signals, false);
     close_shared_queue(queue, false);
     return 0;
 }
@@ -0,0 +1,247 @@
+#include "uring_writer.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static int uring_setup(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int uring_enter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    int rc;
+    do {
+        rc = static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0));
+    } while (rc < 0 && errno == EINTR);
+    return rc;
+}
+
+UringWriter::UringWriter(const std::string& path, LatencyHistogram* write_time) : write_time_(write_time) {
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        std::perror("O_DIRECT open");
+        return;
+    }
+    fd_ = fd;
+    if (!setup_ring()) {
+        std::perror("io_uring_setup");
+        release();
+        return;
+    }
+    for (Buffer& b : buffers_) {
+        b.data = static_cast<uint8_t*>(aligned_alloc(DIRECT_ALIGN, DIRECT_CHUNK));
+        if (!b.data) {
+            release();
+            return;
+        }
+    }
+
+    // one zeroed block through the whole path: a kernel, sandbox or filesystem that can't do
+    // io_uring writes with O_DIRECT fails here rather than halfway through a run
+    std::memset(buffers_[0].data, 0, DIRECT_ALIGN);
+    submit(0, 0, DIRECT_ALIGN);
+    while (in_flight_ && fd_ >= 0) collect(1);
+    if (errors_ || fd_ < 0) {
+        release();
+        return;
+    }
+    buffers_[0].synced = 0;
+}
+
+UringWriter::~UringWriter() {
+    close();
+}
+
+bool UringWriter::setup_ring() {
+    io_uring_params params{};
+    ring_fd_ = uring_setup(DIRECT_BUFFERS, &params);
+    if (ring_fd_ < 0) return false;
+
+    sq_map_len_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_map_len_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single) sq_map_len_ = cq_map_len_ = std::max(sq_map_len_, cq_map_len_);
+
+    sq_map_ = mmap(nullptr, sq_map_len_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                   IORING_OFF_SQ_RING);
+    if (sq_map_ == MAP_FAILED) {
+        sq_map_ = nullptr;
+        return false;
+    }
+    if (single) {
+        cq_map_ = sq_map_;
+    } else {
+        cq_map_ = mmap(nullptr, cq_map_len_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                       IORING_OFF_CQ_RING);
+        if (cq_map_ == MAP_FAILED) {
+            cq_map_ = nullptr;
+            return false;
+        }
+    }
+    sqes_len_ = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = mmap(nullptr, sqes_len_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                      IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) return false;
+    sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+    auto* sq = static_cast<uint8_t*>(sq_map_);
+    auto* cq = static_cast<uint8_t*>(cq_map_);
+    sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_mask_ = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask_ = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    return true;
+}
+
+void UringWriter::release() {
+    if (sqes_) munmap(sqes_, sqes_len_);
+    if (cq_map_ && cq_map_ != sq_map_) munmap(cq_map_, cq_map_len_);
+    if (sq_map_) munmap(sq_map_, sq_map_len_);
+    sqes_ = nullptr;
+    cq_map_ = sq_map_ = nullptr;
+    if (ring_fd_ >= 0) ::close(ring_fd_);
+    if (fd_ >= 0) ::close(fd_);
+    ring_fd_ = fd_ = -1;
+    for (Buffer& b : buffers_) {
+        free(b.data);
+        b.data = nullptr;
+    }
+}
+
+void UringWriter::preallocate(uint64_t end) {
+    if (end <= allocated_) return;
+    uint64_t want = (end / DIRECT_PREALLOC + 1) * DIRECT_PREALLOC;
+    // KEEP_SIZE: the file only grows as it is written, so a crash leaves no run of zeros behind
+    if (fallocate(fd_, FALLOC_FL_KEEP_SIZE, static_cast<off_t>(allocated_), static_cast<off_t>(want - allocated_)) == 0)
+        allocated_ = want;
+    else
+        allocated_ = UINT64_MAX;    // not supported here (or the card is full): just write
+}
+
+void UringWriter::submit(std::size_t index, std::size_t from, std::size_t to) {
+    Buffer& b = buffers_[index];
+    std::size_t len = to - from;
+    preallocate(b.offset + to);
+
+    // the kernel only reads the submission ring on io_uring_enter, from this thread
+    unsigned tail = *sq_tail_;
+    unsigned slot = tail & *sq_mask_;
+    io_uring_sqe* sqe = &sqes_[slot];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_WRITE;
+    sqe->fd = fd_;
+    sqe->addr = reinterpret_cast<uint64_t>(b.data + from);
+    sqe->len = static_cast<uint32_t>(len);
+    sqe->off = b.offset + from;
+    sqe->user_data = index;
+    sq_array_[slot] = slot;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+
+    b.writing = len;
+    b.submit_ns = monotonic_ns();
+    ++in_flight_;
+    if (uring_enter(ring_fd_, 1, 0, 0) < 0) {
+        std::perror("io_uring_enter");
+        b.writing = 0;
+        --in_flight_;
+        ++errors_;
+    }
+}
+
+std::size_t UringWriter::collect(unsigned min_complete) {
+    if (min_complete && uring_enter(ring_fd_, 0, min_complete, IORING_ENTER_GETEVENTS) < 0) {
+        // the ring is unusable: nothing in flight will ever be reported, give the buffers back
+        std::perror("io_uring_enter");
+        for (Buffer& b : buffers_) {
+            if (b.writing) ++errors_;
+            b.writing = 0;
+        }
+        in_flight_ = 0;
+        return 0;
+    }
+
+    unsigned head = *cq_head_;
+    unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    uint64_t now = monotonic_ns();
+    std::size_t n = 0;
+    for (; head != tail; ++head, ++n) {
+        const io_uring_cqe& cqe = cqes_[head & *cq_mask_];
+        Buffer& b = buffers_[cqe.user_data];
+        if (cqe.res != static_cast<int>(b.writing)) {
+            if (!errors_)
+                std::fprintf(stderr, "log write failed: %s\n", cqe.res < 0 ? std::strerror(-cqe.res) : "short write");
+            ++errors_;
+        }
+        if (write_time_) write_time_->record_since(b.submit_ns, now);
+        b.writing = 0;
+        --in_flight_;
+    }
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    return n;
+}
+
+std::size_t UringWriter::reap() {
+    return fd_ >= 0 && in_flight_ ? collect(0) : 0;
+}
+
+void UringWriter::wait_idle(Buffer& b) {
+    while (b.writing) collect(1);
+}
+
+void UringWriter::append(const uint8_t* data, std::size_t len) {
+    while (len && fd_ >= 0) {
+        Buffer& b = buffers_[current_];
+        wait_idle(b);    // its tail may still be on the way out
+        std::size_t take = std::min(len, DIRECT_CHUNK - b.fill);
+        std::memcpy(b.data + b.fill, data, take);
+        b.fill += take;
+        data += take;
+        len -= take;
+        size_ += take;
+        if (b.fill < DIRECT_CHUNK) break;
+
+        // blocks before the last sync's final one are on disk already
+        submit(current_, b.synced & ~(DIRECT_ALIGN - 1), DIRECT_CHUNK);
+        uint64_t next_offset = b.offset + DIRECT_CHUNK;
+        current_ = (current_ + 1) % DIRECT_BUFFERS;
+        Buffer& next = buffers_[current_];
+        wait_idle(next);
+        next.fill = next.synced = 0;
+        next.offset = next_offset;
+    }
+}
+
+void UringWriter::sync_tail() {
+    if (fd_ < 0) return;
+    Buffer& b = buffers_[current_];
+    if (b.fill == b.synced) return;
+    wait_idle(b);
+    // from the block the last sync ended in (rewritten, it holds new bytes now) to the padded fill
+    std::size_t from = b.synced & ~(DIRECT_ALIGN - 1);
+    std::size_t to = (b.fill + DIRECT_ALIGN - 1) & ~(DIRECT_ALIGN - 1);
+    std::memset(b.data + b.fill, 0, to - b.fill);
+    b.synced = b.fill;
+    submit(current_, from, to);
+}
+
+void UringWriter::close() {
+    if (fd_ < 0) {
+        release();
+        return;
+    }
+    sync_tail();
+    while (in_flight_) collect(1);
+    // the last block went out padded
+    if (ftruncate(fd_, static_cast<off_t>(size_)) != 0) std::perror("ftruncate");
+    release();
+}
@@ -0,0 +1,101 @@
+#ifndef FSAE_URING_WRITER_HPP
+#define FSAE_URING_WRITER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "latency_histogram.hpp"
+
+// O_DIRECT wants buffers, offsets and lengths in multiples of the logical block size; 4 KiB
+// covers SD, eMMC and anything else we would log to
+inline constexpr std::size_t DIRECT_ALIGN = 4096;
+inline constexpr std::size_t DIRECT_CHUNK = 256 * 1024;
+// writes in flight at once, each owning one chunk buffer
+inline constexpr std::size_t DIRECT_BUFFERS = 4;
+// the file is grown ahead of the writes by this much, so the card isn't allocating mid-run
+inline constexpr uint64_t DIRECT_PREALLOC = 16 * 1024 * 1024;
+
+// appends to a file with O_DIRECT writes submitted through io_uring, bypassing the page cache
+// so nothing piles up for bursty writeback: bytes collect in aligned chunk buffers, and each
+// full chunk is written from its buffer while the next fills. sync_tail() also writes the
+// partial last chunk, padded with zeros to DIRECT_ALIGN; only the blocks appended to since the
+// last sync are (re)written, and the padding is cut off by close()
+// talks to the kernel through the raw syscalls (no liburing); if the kernel, the sandbox or the
+// filesystem won't do io_uring or O_DIRECT, is_open() is false and the caller falls back
+// single-threaded: every call must come from the same thread
+class UringWriter {
+public:
+    // write_time, if given, records submit -> completion of every write
+    UringWriter(const std::string& path, LatencyHistogram* write_time = nullptr);
+    ~UringWriter();
+
+    UringWriter(const UringWriter&) = delete;
+    UringWriter& operator=(const UringWriter&) = delete;
+
+    bool is_open() const { return fd_ >= 0; }
+
+    // copy len bytes to the end of the file; waits only when every buffer is in flight
+    void append(const uint8_t* data, std::size_t len);
+
+    // submit the partial chunk as well, so everything appended so far is on its way to disk
+    void sync_tail();
+
+    // collect finished writes without waiting; returns how many
+    std::size_t reap();
+
+    // wait for every write, trim the tail padding and close the file
+    void close();
+
+    // bytes appended so far
+    uint64_t size() const { return size_; }
+
+    // writes that failed or came up short (their data is lost)
+    uint64_t errors() const { return errors_; }
+
+private:
+    struct Buffer {
+        uint8_t* data = nullptr;
+        std::size_t fill = 0;       // bytes appended into it
+        uint64_t offset = 0;        // file offset of data[0], a multiple of DIRECT_CHUNK
+        std::size_t synced = 0;     // fill when sync_tail last wrote it
+        std::size_t writing = 0;    // length of the write in flight, 0 = none
+        uint64_t submit_ns = 0;
+    };
+
+    bool setup_ring();
+    // write bytes [from, to) of a buffer at its place in the file; both multiples of DIRECT_ALIGN
+    void submit(std::size_t index, std::size_t from, std::size_t to);
+    // collect completions, waiting for at least min_complete
+    std::size_t collect(unsigned min_complete);
+    // wait for the write in flight from b, if any
+    void wait_idle(Buffer& b);
+    void preallocate(uint64_t end);
+    void release();
+
+    int fd_ = -1;
+    int ring_fd_ = -1;
+    LatencyHistogram* write_time_;
+
+    // the mmapped rings, see linux/io_uring.h
+    void* sq_map_ = nullptr;
+    void* cq_map_ = nullptr;
+    std::size_t sq_map_len_ = 0, cq_map_len_ = 0, sqes_len_ = 0;
+    unsigned* sq_tail_ = nullptr;
+    unsigned* sq_mask_ = nullptr;
+    unsigned* sq_array_ = nullptr;
+    struct io_uring_sqe* sqes_ = nullptr;
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    unsigned* cq_mask_ = nullptr;
+    struct io_uring_cqe* cqes_ = nullptr;
+
+    Buffer buffers_[DIRECT_BUFFERS];
+    std::size_t current_ = 0;       // the buffer being filled
+    std::size_t in_flight_ = 0;
+    uint64_t size_ = 0;
+    uint64_t allocated_ = 0;        // preallocated up to here; UINT64_MAX once fallocate fails
+    uint64_t errors_ = 0;
+};
+
+#endif
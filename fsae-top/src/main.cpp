@@ -0,0 +1,174 @@
+// live view of the /fsae_stats segment
+// usage: fsae-top [interval_s] [iterations]   (iterations 0 = until Ctrl-C)
+
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
+#include "shared_memory.hpp"
+
+static volatile sig_atomic_t running = 1;
+
+static void signal_handler(int) {
+    running = 0;
+}
+
+static uint64_t load(const std::atomic<uint64_t>& v) {
+    return v.load(std::memory_order_relaxed);
+}
+
+// counters restart from zero when their process does, so never report a negative rate
+static double rate(uint64_t now, uint64_t before, double seconds) {
+    return now >= before ? (now - before) / seconds : 0.0;
+}
+
+// previous sample of every counter a rate is derived from
+struct Sample {
+    uint64_t frames[MAX_BUSES], unknown[MAX_BUSES], signals[MAX_BUSES], parse_ns[MAX_BUSES];
+    uint64_t suppressed[MAX_BUSES][PUBLISH_MODES];
+    uint64_t consumed[MAX_CONSUMERS], dropped[MAX_CONSUMERS];
+    uint64_t bytes, flushes, render_frames;
+};
+
+static Sample take_sample(const StatsSegment& s) {
+    Sample out;
+    for (int i = 0; i < MAX_BUSES; ++i) {
+        out.frames[i] = load(s.reader.buses[i].frames);
+        out.unknown[i] = load(s.reader.buses[i].unknown_frames);
+        out.signals[i] = load(s.reader.buses[i].signals);
+        out.parse_ns[i] = load(s.reader.buses[i].parse_ns);
+        for (int m = 0; m < PUBLISH_MODES; ++m) out.suppressed[i][m] = load(s.reader.buses[i].suppressed[m]);
+    }
+    for (int i = 0; i < MAX_CONSUMERS; ++i) {
+        out.consumed[i] = load(s.consumers[i].consumed);
+        out.dropped[i] = load(s.consumers[i].dropped);
+    }
+    out.bytes = load(s.logger.bytes_written);
+    out.flushes = load(s.logger.flushes);
+    out.render_frames = load(s.render.frames);
+    return out;
+}
+
+// pid of a reporting process, flagged idle when its heartbeat is old
+static void print_state(const char* title, int32_t pid, uint64_t heartbeat_ns, uint64_t now) {
+    if (pid == 0) {
+        printf("%-16s down\n", title);
+        return;
+    }
+    double idle = heartbeat_ns && now > heartbeat_ns ? (now - heartbeat_ns) / 1e9 : 0.0;
+    if (idle > 2.0) printf("%-16s pid %-7d idle %.0f s\n", title, pid, idle);
+    else            printf("%-16s pid %-7d\n", title, pid);
+}
+
+static void print_hist(const char* stage, const LatencyHistogram& hist) {
+    LatencySummary l = hist.summary();
+    printf("  %-17s p50 %8.1f us  p99 %8.1f us  p99.9 %8.1f us  max %8.1f us\n",
+           stage, l.p50_ns / 1e3, l.p99_ns / 1e3, l.p999_ns / 1e3, l.max_ns / 1e3);
+}
+
+static void draw(const StatsSegment& s, const Sample& now_s, const Sample& prev, double dt) {
+    uint64_t now = monotonic_ns();
+    const ReaderStats& r = s.reader;
+
+    printf("\033[H\033[2J");
+    printf("fsae-top  (every %.1f s, Ctrl-C to quit)\n\n", dt);
+
+    print_state("can-reader", r.pid.load(std::memory_order_relaxed), load(r.heartbeat_ns), now);
+    uint64_t write_idx = load(r.queue_write_idx);
+    printf("  queue idx %llu   decimated %llu   lost to full spill %llu\n", static_cast<unsigned long long>(write_idx),
+           static_cast<unsigned long long>(load(r.decimated)), static_cast<unsigned long long>(load(r.spill_full)));
+    printf("  %-10s %10s %10s %12s %10s %10s %10s\n", "bus", "frames/s", "unknown/s", "signals/s",
+           "ns/frame", "overflows", "rejected");
+    for (int i = 0; i < MAX_BUSES; ++i) {
+        const BusStats& b = r.buses[i];
+        if (b.interface[0] == '\0') continue;
+        uint64_t frames = now_s.frames[i] >= prev.frames[i] ? now_s.frames[i] - prev.frames[i] : 0;
+        uint64_t parse = now_s.parse_ns[i] >= prev.parse_ns[i] ? now_s.parse_ns[i] - prev.parse_ns[i] : 0;
+        printf("  %-10.*s %10.0f %10.0f %12.0f %10.0f %10llu %10llu\n",
+               static_cast<int>(BUS_NAME_LEN), b.interface,
+               rate(now_s.frames[i], prev.frames[i], dt), rate(now_s.unknown[i], prev.unknown[i], dt),
+               rate(now_s.signals[i], prev.signals[i], dt), frames ? static_cast<double>(parse) / frames : 0.0,
+               static_cast<unsigned long long>(load(b.socket_overflows)),
+               static_cast<unsigned long long>(load(b.filter_rejects)));
+        double saved[PUBLISH_MODES], saved_total = 0.0;
+        for (int m = 0; m < PUBLISH_MODES; ++m) {
+            saved[m] = rate(now_s.suppressed[i][m], prev.suppressed[i][m], dt);
+            saved_total += saved[m];
+        }
+        if (saved_total > 0.0)
+            printf("  %-10s saved/s: on_change %.0f  deadband %.0f  rate %.0f\n", "",
+                   saved[static_cast<int>(PublishMode::ON_CHANGE)], saved[static_cast<int>(PublishMode::DEADBAND)],
+                   saved[static_cast<int>(PublishMode::RATE)]);
+        if (load(b.config_swaps))
+            printf("  %-10s %llu config swaps, last in use %.1f us after publish, compiled in %.2f ms\n", "",
+                   static_cast<unsigned long long>(load(b.config_swaps)), load(b.swap_latency_ns) / 1e3,
+                   load(b.compile_ns) / 1e6);
+    }
+    print_hist("rx->queue", r.rx_to_queue);
+
+    static const char* const pressure_names[] = {"ok", "warn", "decimate", "spill", "stalled"};
+    printf("\n%-16s %-7s %-8s %10s %12s %10s %10s %12s %12s %12s %12s\n", "consumer", "pid", "state", "lag",
+           "consumed/s", "dropped/s", "spilled", "rx->cons p50", "p99 (us)", "q->cons p50", "p99 (us)");
+    for (int i = 0; i < MAX_CONSUMERS; ++i) {
+        const ConsumerStats& c = s.consumers[i];
+        int32_t pid = c.pid.load(std::memory_order_acquire);
+        if (pid == 0) continue;
+        uint64_t pos = load(c.position);
+        uint32_t pressure = c.pressure.load(std::memory_order_relaxed);
+        LatencySummary l = c.rx_to_consume.summary();
+        LatencySummary q = c.queue_to_consume.summary();
+        printf("%-16.*s %-7d %-8s %10llu %12.0f %10.0f %10llu %12.1f %12.1f %12.1f %12.1f\n",
+               static_cast<int>(CONSUMER_NAME_LEN), c.name, pid,
+               pressure <= static_cast<uint32_t>(ConsumerPressure::STALLED) ? pressure_names[pressure] : "?",
+               static_cast<unsigned long long>(write_idx > pos ? write_idx - pos : 0),
+               rate(now_s.consumed[i], prev.consumed[i], dt), rate(now_s.dropped[i], prev.dropped[i], dt),
+               static_cast<unsigned long long>(load(c.spilled)), l.p50_ns / 1e3, l.p99_ns / 1e3, q.p50_ns / 1e3,
+               q.p99_ns / 1e3);
+    }
+
+    printf("\n");
+    print_state("data-logger", s.logger.pid.load(std::memory_order_relaxed), load(s.logger.heartbeat_ns), now);
+    printf("  %10.1f KiB/s   %8.0f flushes/s   %llu lost to a slow card\n", rate(now_s.bytes, prev.bytes, dt) / 1024.0,
+           rate(now_s.flushes, prev.flushes, dt), static_cast<unsigned long long>(load(s.logger.lost)));
+    print_hist("flush", s.logger.flush_time);
+    print_hist("rx->disk", s.logger.rx_to_disk);
+
+    printf("\n");
+    print_state("graphics-engine", s.render.pid.load(std::memory_order_relaxed), load(s.render.heartbeat_ns), now);
+    printf("  %6.1f fps\n", rate(now_s.render_frames, prev.render_frames, dt));
+    print_hist("frame time", s.render.frame_time);
+    print_hist("consume->present", s.render.consume_to_present);
+    fflush(stdout);
+}
+
+int main(int argc, char* argv[]) {
+    double interval = (argc > 1) ? std::atof(argv[1]) : 1.0;
+    long iterations = (argc > 2) ? std::atol(argv[2]) : 0;
+    if (interval <= 0.0) interval = 1.0;
+
+    struct sigaction sa{};
+    sa.sa_handler = signal_handler;
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+
+    StatsSegment* stats = open_stats_segment();
+    if (!stats) {
+        std::perror("Failed to open stats segment");
+        return 1;
+    }
+
+    Sample prev = take_sample(*stats);
+    uint64_t prev_time = monotonic_ns();
+    for (long n = 0; running && (iterations == 0 || n < iterations); ++n) {
+        usleep(static_cast<useconds_t>(interval * 1e6));
+        Sample now_s = take_sample(*stats);
+        uint64_t now = monotonic_ns();
+        draw(*stats, now_s, prev, (now - prev_time) / 1e9);
+        prev = now_s;
+        prev_time = now;
+    }
+
+    close_stats_segment(stats);
+    return 0;
+}
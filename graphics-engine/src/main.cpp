@@ -3,6 +3,31 @@
 #include "WidgetFactory.h"
 #include "config_parser.hpp"
 #include "shared_memory.hpp"
+#include "latency_histogram.hpp"
+
+#include <unistd.h>
+#include <vector>
+
+// map signal IDs to the widgets showing them; widgets whose signal isn't published yet stay unbound
+static void bind_widgets(const std::vector<LiveWidget>& widgets, const SignalTable& signals,
+                         std::vector<std::vector<std::size_t>>& by_signal) {
+    by_signal.assign(MAX_SIGNALS, {});
+    for (std::size_t i = 0; i < widgets.size(); ++i) {
+        uint16_t id = signals.find(widgets[i].can_id, widgets[i].signal);
+        if (id != INVALID_SIGNAL_ID) by_signal[id].push_back(i);
+    }
+}
+
+// fill every bound widget from the latest-value table, for late attach or after falling behind
+static void refresh_widgets(std::vector<LiveWidget>& widgets, const SignalTable& signals,
+                            const std::vector<std::vector<std::size_t>>& by_signal) {
+    for (std::size_t id = 0; id < by_signal.size(); ++id) {
+        LatestValue latest;
+        if (by_signal[id].empty() || !signals.read_latest(static_cast<uint16_t>(id), latest)) continue;
+        for (std::size_t i : by_signal[id])
+            widgets[i].set_value(latest.value);
+    }
+}
 
 int main(int argc, char* argv[])
 {
@@ -21,15 +46,58 @@ int main(int argc, char* argv[])
     TelemetryQueue* queue = open_shared_queue(false);
     std::size_t consumer_pos = queue ? queue->current_pos() : 0;
 
+    SignalTable* signals = open_signal_table(false);
+    std::vector<std::vector<std::size_t>> widgets_by_signal;
+    uint32_t bound_count = 0;
+
+    // metrics are best effort: without the segment they go to a private copy
+    static StatsSegment local_stats;
+    StatsSegment* shared_stats = open_stats_segment();
+    StatsSegment& stats = shared_stats ? *shared_stats : local_stats;
+    ConsumerStats* consumer = queue ? claim_consumer_stats(stats, "graphics") : nullptr;
+    if (!consumer)
+        consumer = &local_stats.consumers[0];
+    RenderStats& render = stats.render;
+    render.pid.store(static_cast<int32_t>(getpid()), std::memory_order_relaxed);
+    render.frame_time.reset();
+    render.consume_to_present.reset();
+
+    // kernel RX and queue push -> consumed by the render loop, per message; consumed -> frame
+    // presented, per frame
+    LatencyHistogram& rx_to_consume = consumer->rx_to_consume;
+    LatencyHistogram& queue_to_consume = consumer->queue_to_consume;
+    LatencyHistogram& consume_to_present = render.consume_to_present;
+    uint64_t last_present = monotonic_ns();
+
     while (!WindowShouldClose())
     {
+        // names are only compared when can-reader publishes new signals
+        if (signals && signals->count.load(std::memory_order_acquire) != bound_count) {
+            bound_count = signals->count.load(std::memory_order_acquire);
+            bind_widgets(widgets, *signals, widgets_by_signal);
+            refresh_widgets(widgets, *signals, widgets_by_signal);
+        }
+
+        uint64_t consumed_at = 0;
         if (queue) {
-            queue->consume(consumer_pos, [&widgets](const TelemetryMessage& msg) {
-                for (auto& lw : widgets) {
-                    if (lw.can_id == msg.can_id && lw.signal == msg.signal_name)
-                        lw.set_value(msg.value);
-                }
+            consumed_at = monotonic_ns();
+            std::size_t before = consumer_pos;
+            std::size_t dropped = queue->consume(consumer_pos, [&](const TelemetryMessage& msg) {
+                rx_to_consume.record_since(msg.ingest_ns, consumed_at);
+                queue_to_consume.record_since(msg.queued_ns(), consumed_at);
+                if (msg.signal_id >= widgets_by_signal.size()) return;
+                for (std::size_t i : widgets_by_signal[msg.signal_id])
+                    widgets[i].set_value(msg.value);
             });
+            if (consumer_pos == before)
+                consumed_at = 0;
+            // lapped: skip the lost history and jump straight to current state
+            if (dropped && signals)
+                refresh_widgets(widgets, *signals, widgets_by_signal);
+
+            stat_add(consumer->consumed, consumer_pos - before - dropped);
+            stat_add(consumer->dropped, dropped);
+            stat_set(consumer->position, consumer_pos);
         }
 
         BeginDrawing();
@@ -39,10 +107,30 @@ int main(int argc, char* argv[])
             lw.draw(uiFont);
 
         EndDrawing();
+        uint64_t presented = monotonic_ns();
+        if (consumed_at)
+            consume_to_present.record_since(consumed_at, presented);
+
+        render.frame_time.record_since(last_present, presented);
+        last_present = presented;
+        stat_add(render.frames);
+        stat_set(render.heartbeat_ns, presented);
+        stat_set(consumer->heartbeat_ns, presented);
     }
 
+    print_latency("rx->consume", rx_to_consume);
+    print_latency("queue->consume", queue_to_consume);
+    print_latency("consume->present", consume_to_present);
+
+    render.pid.store(0, std::memory_order_relaxed);
+    release_consumer_stats(consumer);
+    if (shared_stats)
+        close_stats_segment(shared_stats);
+
     if (queue)
         close_shared_queue(queue, false);
+    if (signals)
+        close_signal_table(signals, false);
 
     UnloadFont(uiFont);
     CloseWindow();
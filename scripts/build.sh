@@ -14,6 +14,9 @@ make -C data-logger clean && make -C data-logger
 # echo "Installing Node dependencies..."
 # cd web-server && npm install
 
+echo "Building fsae-top..."
+make -C fsae-top clean && make -C fsae-top
+
 echo "Building Tests..."
 make -C tests clean && make -C tests
 
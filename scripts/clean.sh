@@ -11,6 +11,9 @@ cd graphics-engine && make clean && cd ..
 echo "Cleaning Data Logger..."
 cd data-logger && make clean && cd ..
 
+echo "Cleaning fsae-top..."
+cd fsae-top && make clean && cd ..
+
 echo "Cleaning Tests"
 cd tests && make clean && cd ..
 
@@ -2,7 +2,7 @@
 
 cd "$(dirname "$0")/.."
 
-for module in can-reader data-logger graphics-engine; do
+for module in can-reader data-logger graphics-engine fsae-top; do
     echo "Generating for $module..."
     cd "$module"
     make clean -s 2>/dev/null
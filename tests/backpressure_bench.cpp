@@ -0,0 +1,254 @@
+// consumer backpressure: a lossless consumer that falls far behind still gets every item, in order,
+// through the spill ring; a lagging lossy consumer turns on decimation of low-priority signals,
+// and catching up (or stalling) turns it off; then times publishing with each mechanism armed
+// producer, consumers and monitor are stepped in one thread, so every run is the same
+// usage: backpressure_bench [messages]
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "backpressure.hpp"
+#include "bench_util.hpp"
+
+static constexpr std::size_t QUEUE_CAPACITY = 1024;
+static constexpr uint16_t NORMAL_ID = 0;
+static constexpr uint16_t LOW_ID = 1;
+static constexpr std::size_t PUBLISH_BATCH = 16;
+
+// queue, publisher, spill ring and monitor over a private stats segment
+struct Rig {
+    void* queue_memory;
+    void* spill_memory = nullptr;
+    TelemetryQueue* queue;
+    SpillRing* spill = nullptr;
+    StatsSegment* stats;
+    SignalTable* signals;
+    TelemetryPublisher* publisher;
+    BackpressureMonitor* monitor;
+    uint64_t next = 0;      // value of the next message published
+
+    Rig(std::size_t spill_capacity, bool low_priority) {
+        queue_memory = aligned_alloc(64, (TelemetryQueue::bytes_for(QUEUE_CAPACITY) + 63) & ~std::size_t{63});
+        queue = TelemetryQueue::create(queue_memory, QUEUE_CAPACITY);
+        if (spill_capacity) {
+            spill_memory = aligned_alloc(64, (SpillRing::bytes_for(spill_capacity) + 63) & ~std::size_t{63});
+            spill = SpillRing::create(spill_memory, spill_capacity);
+        }
+        stats = new StatsSegment();
+        signals = new SignalTable();
+        publisher = new TelemetryPublisher(*queue, *signals, stats->reader);
+        std::vector<uint8_t> low(MAX_SIGNALS, 0);
+        if (low_priority) low[LOW_ID] = 1;
+        publisher->set_low_priority(low);
+
+        BackpressureConfig config;
+        config.warn_lag = 0.5;
+        config.decimate_lag = 0.75;
+        config.decimate_keep = 4;
+        config.spill_capacity = spill_capacity;
+        monitor = new BackpressureMonitor(*publisher, *stats, QUEUE_CAPACITY, spill, config);
+    }
+
+    ~Rig() {
+        delete monitor;
+        delete publisher;
+        delete signals;
+        delete stats;
+        free(spill_memory);
+        free(queue_memory);
+    }
+
+    // one batch, alternating normal and low-priority signals
+    void publish(std::size_t count = PUBLISH_BATCH) {
+        TelemetryMessage msgs[PUBLISH_BATCH];
+        uint64_t wall[PUBLISH_BATCH] = {};
+        for (std::size_t i = 0; i < count; ++i, ++next) {
+            msgs[i] = TelemetryMessage{next % 2 ? LOW_ID : NORMAL_ID, 0, 0, static_cast<double>(next), next};
+        }
+        publisher->publish(msgs, wall, count);
+    }
+
+    void check() { monitor->check(queue->current_pos(), monotonic_ns()); }
+};
+
+// the data-logger's loop: spill first, then a batch from the queue, starting over from the spill
+// when the front of the batch was overwritten while held; `between` runs where the logger would
+// be writing to disk, so the producer can overwrite what it holds
+struct LosslessReader {
+    std::size_t pos = 0;
+    std::size_t dropped = 0;
+    std::vector<uint64_t> got;
+
+    template <typename Between>
+    void step(Rig& rig, ConsumerStats& slot, int32_t slot_index, std::size_t max_items, Between between) {
+        bool spilling = rig.spill && rig.spill->consumer() == slot_index;
+        if (spilling)
+            rig.spill->replay(pos, [&](const TelemetryMessage& msg) { got.push_back(static_cast<uint64_t>(msg.value)); });
+
+        auto batch = rig.queue->peek_batch(pos, max_items);
+        std::vector<uint64_t> staged;
+        for (std::size_t i = 0; i < batch.first_len; ++i) staged.push_back(static_cast<uint64_t>(batch.first[i].value));
+        for (std::size_t i = 0; i < batch.second_len; ++i) staged.push_back(static_cast<uint64_t>(batch.second[i].value));
+        between();
+
+        std::size_t overwritten = rig.queue->commit(pos, batch);
+        dropped += batch.dropped;
+        if (overwritten && spilling) {
+            pos = batch.begin;
+        } else {
+            dropped += overwritten;
+            got.insert(got.end(), staged.begin() + static_cast<long>(overwritten), staged.end());
+        }
+        stat_set(slot.position, pos);
+        stat_set(slot.heartbeat_ns, monotonic_ns());
+    }
+};
+
+// 300 rounds of 64 published / at most 48 read, then read until caught up
+// returns true if the reader saw every value in order
+static bool lossless_run(Rig& rig, std::size_t& spilled, std::size_t& full, std::size_t& dropped) {
+    ConsumerStats* slot = claim_consumer_stats(*rig.stats, "logger", CONSUMER_LOSSLESS);
+    int32_t slot_index = static_cast<int32_t>(slot - rig.stats->consumers);
+    LosslessReader reader;
+    stat_set(slot->position, reader.pos);
+    rig.check();
+
+    for (int round = 0; round < 300; ++round) {
+        reader.step(rig, *slot, slot_index, 48, [&] {
+            for (int b = 0; b < 4; ++b) rig.publish();
+        });
+        rig.check();
+    }
+    while (reader.pos < rig.queue->current_pos() || (rig.spill && rig.spill->size())) {
+        reader.step(rig, *slot, slot_index, 4096, [] {});
+        rig.check();
+    }
+
+    spilled = slot->spilled.load();
+    full = rig.stats->reader.spill_full.load();
+    dropped = reader.dropped;
+    bool in_order = reader.got.size() == rig.next;
+    for (std::size_t i = 0; in_order && i < reader.got.size(); ++i) in_order = reader.got[i] == i;
+    release_consumer_stats(slot);
+    return in_order;
+}
+
+int main(int argc, char* argv[]) {
+    long timed = (argc > 1) ? std::atol(argv[1]) : 4000000;
+    bool ok = true;
+
+    printf("lossless consumer, queue %zu, reading 48 of every 64 items for 300 rounds:\n", QUEUE_CAPACITY);
+    {
+        Rig rig(8192, false);
+        std::size_t spilled, full, dropped;
+        bool in_order = lossless_run(rig, spilled, full, dropped);
+        printf("  %zu spilled, %zu lost to a full ring, %zu dropped\n", spilled, full, dropped);
+        ok &= expect("every item arrives once, in order", in_order);
+        ok &= expect("items went through the spill ring", spilled > 0 && full == 0 && dropped == 0);
+    }
+    {
+        Rig rig(32, false);
+        std::size_t spilled, full, dropped;
+        bool in_order = lossless_run(rig, spilled, full, dropped);
+        printf("  spill ring of 32: %zu spilled, %zu lost to a full ring, %zu dropped\n", spilled, full, dropped);
+        ok &= expect("small ring: losses are counted", !in_order && full > 0 && dropped > 0);
+    }
+    {
+        Rig rig(0, false);
+        std::size_t spilled, full, dropped;
+        bool in_order = lossless_run(rig, spilled, full, dropped);
+        printf("  spilling off: %zu dropped\n", dropped);
+        ok &= expect("no spill ring: the reader is lapped", !in_order && spilled == 0 && dropped > 0);
+    }
+
+    printf("lossy consumer, low-priority signal kept 1 in 4 while decimating:\n");
+    {
+        Rig rig(8192, true);
+        ConsumerStats* slot = claim_consumer_stats(*rig.stats, "graphics");
+        auto level = [&] { return static_cast<ConsumerPressure>(slot->pressure.load()); };
+
+        // half a queue behind: a warning only
+        for (std::size_t i = 0; i < QUEUE_CAPACITY / 2 / PUBLISH_BATCH; ++i) rig.publish();
+        rig.check();
+        ok &= expect("half a queue behind: warn", level() == ConsumerPressure::WARN && !rig.monitor->decimating());
+
+        for (std::size_t i = 0; i < QUEUE_CAPACITY / 4 / PUBLISH_BATCH; ++i) rig.publish();
+        rig.check();
+        ok &= expect("three quarters behind: decimate", level() == ConsumerPressure::DECIMATE && rig.monitor->decimating());
+
+        std::size_t before = rig.queue->current_pos();
+        uint64_t held_before = rig.stats->reader.decimated.load();
+        for (int i = 0; i < 64; ++i) rig.publish();
+        std::size_t pushed = rig.queue->current_pos() - before;
+        uint64_t held = rig.stats->reader.decimated.load() - held_before;
+        printf("  1024 published while decimating: %zu pushed, %llu held back\n", pushed,
+               static_cast<unsigned long long>(held));
+        ok &= expect("normal signal untouched, low-priority 1 in 4", pushed == 512 + 128 && held == 384);
+
+        // back under warn_lag: decimation stops
+        stat_set(slot->position, rig.queue->current_pos());
+        rig.check();
+        ok &= expect("caught up: decimation off", level() == ConsumerPressure::OK && !rig.monitor->decimating());
+
+        // a consumer that stops reporting doesn't hold everybody else's data hostage
+        for (std::size_t i = 0; i < QUEUE_CAPACITY / PUBLISH_BATCH; ++i) rig.publish();
+        stat_set(slot->heartbeat_ns, monotonic_ns() - 10000000000ull);
+        rig.check();
+        ok &= expect("stalled consumer: ignored", level() == ConsumerPressure::STALLED && !rig.monitor->decimating());
+        release_consumer_stats(slot);
+    }
+    if (!ok) {
+        printf("FAIL\n");
+        return 1;
+    }
+
+    // publish cost with nothing armed, with a caught-up lossless consumer (checked per push, never
+    // spilling), with a lossless consumer lapped on every push, and while decimating
+    auto time_publish = [&](Rig& rig, const char* what, ConsumerStats* follow) {
+        auto start = std::chrono::steady_clock::now();
+        for (long n = 0; n < timed / static_cast<long>(PUBLISH_BATCH); ++n) {
+            rig.publish();
+            if (follow) stat_set(follow->position, rig.queue->current_pos());
+            // the lossless reader keeps the spill ring drained so it never fills
+            if (rig.spill && rig.spill->size() > rig.spill->capacity() / 2) {
+                std::size_t pos = SIZE_MAX;
+                rig.spill->replay(pos, [](const TelemetryMessage&) {});
+            }
+        }
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        printf("%-26s %8.2f ns/msg\n", what, secs * 1e9 / (timed / PUBLISH_BATCH * PUBLISH_BATCH));
+    };
+    {
+        Rig rig(0, false);
+        time_publish(rig, "plain", nullptr);
+    }
+    {
+        Rig rig(8192, false);
+        ConsumerStats* slot = claim_consumer_stats(*rig.stats, "logger", CONSUMER_LOSSLESS);
+        stat_set(slot->heartbeat_ns, monotonic_ns());
+        rig.check();
+        time_publish(rig, "spill armed, caught up", slot);
+        release_consumer_stats(slot);
+    }
+    {
+        Rig rig(8192, false);
+        ConsumerStats* slot = claim_consumer_stats(*rig.stats, "logger", CONSUMER_LOSSLESS);
+        rig.check();
+        time_publish(rig, "spilling every push", nullptr);
+        release_consumer_stats(slot);
+    }
+    {
+        Rig rig(0, true);
+        ConsumerStats* slot = claim_consumer_stats(*rig.stats, "graphics");
+        for (std::size_t i = 0; i < QUEUE_CAPACITY / PUBLISH_BATCH; ++i) rig.publish();
+        rig.check();
+        time_publish(rig, "decimating", nullptr);
+        release_consumer_stats(slot);
+    }
+
+    printf("PASS\n");
+    return 0;
+}
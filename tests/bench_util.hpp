@@ -0,0 +1,47 @@
+#ifndef FSAE_BENCH_UTIL_HPP
+#define FSAE_BENCH_UTIL_HPP
+
+// helpers the benches share: pass/fail reporting and synthetic signal configs
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include "config_types.hpp"
+
+// one "ok" / "FAIL" line per check; returns ok
+inline bool expect(const char* what, bool ok) {
+    printf("  %-52s %s\n", what, ok ? "ok" : "FAIL");
+    return ok;
+}
+
+// prints the count, and what was wanted if it differs
+inline bool expect(const char* what, uint64_t got, uint64_t want) {
+    printf("  %-20s %8llu\n", what, static_cast<unsigned long long>(got));
+    if (got == want) return true;
+    printf("FAIL %s: want %llu\n", what, static_cast<unsigned long long>(want));
+    return false;
+}
+
+// silent unless got != want
+inline bool check(const char* what, double got, double want) {
+    if (got == want) return true;
+    printf("FAIL %s: got %f, want %f\n", what, got, want);
+    return false;
+}
+
+// an unscaled signal, 16-bit little-endian unsigned unless told otherwise
+inline ChannelConfig make_channel(const std::string& name, int start_bit, int bit_length = 16,
+                                  ByteOrder order = ByteOrder::INTEL, SignalType type = SignalType::UNSIGNED) {
+    ChannelConfig cfg;
+    cfg.name = name;
+    cfg.start_bit = static_cast<uint16_t>(start_bit);
+    cfg.bit_length = static_cast<uint8_t>(bit_length);
+    cfg.byte_order = order;
+    cfg.type = type;
+    cfg.scale = 1.0;
+    cfg.offset = 0.0;
+    return cfg;
+}
+
+#endif
@@ -0,0 +1,125 @@
+// aggregate ingest throughput with 1, 2 and 4 bus threads merging into one ring
+// frames are synthesized in memory (no vcan needed) and fed through BusIngest, the same
+// decode + publish path the bus reader threads use; a consumer thread checks per-bus order
+// usage: bus_merge_bench [frames_per_bus]
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "bus_reader.hpp"
+#include "bench_util.hpp"
+
+static constexpr int SIGNALS_PER_FRAME = 4;
+static constexpr int IDS_PER_BUS = 16;
+
+// bus b uses IDs 0x100 * (b + 1) + n; signal 0 of every frame is the bus's frame counter
+static FrameMap make_bus_frames(int bus) {
+    FrameMap frames;
+    for (int n = 0; n < IDS_PER_BUS; ++n) {
+        auto& channels = frames[0x100u * (bus + 1) + n];
+        for (int k = 0; k < SIGNALS_PER_FRAME; ++k) {
+            ChannelConfig cfg = make_channel("sig_" + std::to_string(k), k * 16, k == 0 ? 32 : 16);
+            cfg.signal_id = static_cast<uint16_t>(bus * SIGNALS_PER_FRAME + k);
+            channels.push_back(cfg);
+        }
+    }
+    return frames;
+}
+
+// two 16-bit signals overlap the counter's high half; only signal 0 is checked
+static void fill_frame(CanRxFrame& rx, int bus, uint32_t seq) {
+    memset(&rx, 0, sizeof(rx));
+    rx.frame.can_id = 0x100u * (bus + 1) + seq % IDS_PER_BUS;
+    rx.frame.len = 8;
+    memcpy(rx.frame.data, &seq, sizeof(seq));
+    rx.rx_mono_ns = monotonic_ns();
+    rx.rx_time_ns = rx.rx_mono_ns;
+}
+
+struct Result {
+    double frames_per_s;
+    double msgs_per_s;
+    uint64_t seen;
+    uint64_t dropped;
+    uint64_t disorder;
+};
+
+static Result run(int bus_count, uint32_t frames_per_bus, TelemetryQueue& queue, SignalTable& signals) {
+    static StatsSegment stats;
+    TelemetryPublisher publisher(queue, signals, stats.reader);
+
+    std::atomic<int> done{0};
+    Result result{};
+
+    std::thread consumer([&] {
+        std::size_t pos = queue.current_pos();
+        int64_t last[MAX_BUSES];
+        for (auto& l : last) l = -1;
+        for (;;) {
+            bool finished = done.load(std::memory_order_acquire) == bus_count;
+            result.dropped += queue.consume(pos, [&](const TelemetryMessage& msg) {
+                ++result.seen;
+                if (msg.signal_id % SIGNALS_PER_FRAME != 0) return;
+                int bus = msg.signal_id / SIGNALS_PER_FRAME;
+                int64_t seq = static_cast<int64_t>(msg.value);
+                if (seq <= last[bus]) ++result.disorder;
+                last[bus] = seq;
+            });
+            if (finished && pos == queue.current_pos()) break;
+        }
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> producers;
+    for (int b = 0; b < bus_count; ++b) {
+        producers.emplace_back([&, b] {
+            TraceRing trace;
+            BusIngest ingest(publisher, stats.reader.buses[b], trace);
+            ingest.set_decoder(std::make_unique<FrameDecoder>(make_bus_frames(b)));
+
+            CanRxFrame rx[CAN_RX_BATCH];
+            for (uint32_t seq = 0; seq < frames_per_bus; seq += CAN_RX_BATCH) {
+                int n = 0;
+                for (; n < CAN_RX_BATCH && seq + n < frames_per_bus; ++n) fill_frame(rx[n], b, seq + n);
+                ingest.process(rx, n);
+            }
+            done.fetch_add(1, std::memory_order_release);
+        });
+    }
+    for (auto& t : producers) t.join();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    consumer.join();
+
+    result.frames_per_s = bus_count * static_cast<double>(frames_per_bus) / secs;
+    result.msgs_per_s = result.frames_per_s * SIGNALS_PER_FRAME;
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t frames_per_bus = (argc > 1) ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 2000000;
+
+    const std::size_t capacity = 16384;
+    void* memory = aligned_alloc(64, (TelemetryQueue::bytes_for(capacity) + 63) & ~std::size_t{63});
+    TelemetryQueue* queue = TelemetryQueue::create(memory, capacity);
+    static SignalTable signals;
+
+    bool ok = true;
+    for (int buses : {1, 2, 4}) {
+        Result r = run(buses, frames_per_bus, *queue, signals);
+        printf("%d bus%s  %6.2f M frames/s  %6.2f M msgs/s  consumer saw %llu, dropped %llu, %llu out of order\n",
+               buses, buses == 1 ? " " : "es", r.frames_per_s / 1e6, r.msgs_per_s / 1e6,
+               static_cast<unsigned long long>(r.seen), static_cast<unsigned long long>(r.dropped),
+               static_cast<unsigned long long>(r.disorder));
+        ok &= r.disorder == 0 &&
+              r.seen + r.dropped == static_cast<uint64_t>(buses) * frames_per_bus * SIGNALS_PER_FRAME;
+    }
+
+    free(memory);
+    printf("%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
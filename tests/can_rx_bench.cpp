@@ -0,0 +1,123 @@
+// compares per-frame read() against batched recvmmsg ingestion on a CAN interface
+// usage: can_rx_bench [interface] [frames]   (needs a vcan, e.g. `ip link add vcan0 type vcan`)
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include <linux/can/raw.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include "can_socket.hpp"
+
+// frames the sender may have in flight; stays well under the socket receive buffer
+static constexpr int BURST = 256;
+
+static int open_sender(const std::string& interface) {
+    int fd = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+    if (fd == -1) return -1;
+
+    // don't loop our own frames back into the sender socket
+    int off = 0;
+    setsockopt(fd, SOL_CAN_RAW, CAN_RAW_RECV_OWN_MSGS, &off, sizeof(off));
+
+    struct ifreq ifr{};
+    strncpy(ifr.ifr_name, interface.c_str(), IFNAMSIZ - 1);
+    if (ioctl(fd, SIOCGIFINDEX, &ifr) == -1) {
+        ::close(fd);
+        return -1;
+    }
+
+    struct sockaddr_can addr{};
+    addr.can_family = AF_CAN;
+    addr.can_ifindex = ifr.ifr_ifindex;
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) == -1) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+struct Result {
+    long frames;
+    long syscalls;
+    double seconds;
+};
+
+template <typename ReadFn>
+static Result run(const std::string& interface, long total, ReadFn read_some) {
+    CanSocket sock;
+    if (!sock.open(interface)) {
+        std::perror("Failed to open CAN socket");
+        std::exit(1);
+    }
+    int tx = open_sender(interface);
+    if (tx == -1) {
+        std::perror("Failed to open sender socket");
+        std::exit(1);
+    }
+
+    std::atomic<long> received{0};
+    std::thread sender([&] {
+        can_frame f{};
+        f.can_id = 0x100;
+        f.can_dlc = 8;
+        for (long sent = 0; sent < total; ++sent) {
+            // throttle so the receive queue never overflows and drops frames
+            while (sent - received.load(std::memory_order_acquire) >= BURST) {
+                std::this_thread::yield();
+            }
+            memcpy(f.data, &sent, sizeof(sent));
+            if (::write(tx, &f, sizeof(f)) != sizeof(f)) {
+                std::perror("write");
+                std::exit(1);
+            }
+        }
+    });
+
+    Result r{0, 0, 0.0};
+    auto start = std::chrono::steady_clock::now();
+    while (r.frames < total) {
+        int n = read_some(sock);
+        ++r.syscalls;
+        if (n > 0) {
+            r.frames += n;
+            received.store(r.frames, std::memory_order_release);
+        }
+    }
+    r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    sender.join();
+    ::close(tx);
+    return r;
+}
+
+static void report(const char* name, const Result& r) {
+    printf("%-10s %10ld frames  %8.3f syscalls/frame  %10.0f frames/s\n",
+           name, r.frames, (double)r.syscalls / r.frames, r.frames / r.seconds);
+}
+
+int main(int argc, char* argv[]) {
+    std::string interface = (argc > 1) ? argv[1] : "vcan0";
+    long total = (argc > 2) ? std::atol(argv[2]) : 500000;
+
+    Result single = run(interface, total, [](CanSocket& s) {
+        can_frame frame;
+        return s.read(frame) ? 1 : 0;
+    });
+
+    static CanRxFrame rx[CAN_RX_BATCH];
+    Result batched = run(interface, total, [](CanSocket& s) {
+        return s.read_batch(rx, CAN_RX_BATCH);
+    });
+
+    report("read", single);
+    report("recvmmsg", batched);
+    return 0;
+}
@@ -0,0 +1,396 @@
+// compares FrameMap lookup + parse_value, the old byte-aligned memcpy extractor,
+// and the compiled FrameDecoder; also checks bit-level decoding against known values,
+// times 64-byte CAN FD payloads as the signal count grows, and checks multiplexed DBC
+// messages against a naive test-every-signal decode
+// usage: decode_bench [frames]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "dbc_parser.hpp"
+#include "frame_decoder.hpp"
+#include "frame_parser.hpp"
+#include "bench_util.hpp"
+
+// 64 standard IDs and 16 extended IDs, 4 signals each
+// aligned: the layouts the old memcpy extractor could handle; otherwise 12-bit, 1-bit and Motorola signals
+static FrameMap make_frame_map(bool aligned) {
+    FrameMap frames;
+    for (uint32_t n = 0; n < 80; ++n) {
+        uint32_t can_id = n < 64 ? 0x100 + n * 3 : (CAN_EFF_FLAG | (0x18FF0000u + n));
+        auto& channels = frames[can_id];
+        std::string prefix = "sig_" + std::to_string(n) + "_";
+        if (aligned) {
+            channels.push_back(make_channel(prefix + "0", 0, 16, ByteOrder::INTEL, SignalType::UNSIGNED));
+            channels.push_back(make_channel(prefix + "1", 16, 16, ByteOrder::INTEL, SignalType::SIGNED));
+            channels.push_back(make_channel(prefix + "2", 32, 8, ByteOrder::INTEL, SignalType::UNSIGNED));
+            channels.push_back(make_channel(prefix + "3", 40, 8, ByteOrder::INTEL, SignalType::SIGNED));
+        } else {
+            channels.push_back(make_channel(prefix + "0", 0, 12, ByteOrder::INTEL, SignalType::UNSIGNED));
+            channels.push_back(make_channel(prefix + "1", 12, 1, ByteOrder::INTEL, SignalType::UNSIGNED));
+            channels.push_back(make_channel(prefix + "2", 23, 12, ByteOrder::MOTOROLA, SignalType::SIGNED));
+            channels.push_back(make_channel(prefix + "3", 39, 16, ByteOrder::MOTOROLA, SignalType::UNSIGNED));
+        }
+    }
+    return frames;
+}
+
+// the pre-bit-level extractor: whole bytes, host order, type from the bit length
+template <typename T>
+static double legacy_extract(const can_frame& frame, const ChannelConfig& cfg) {
+    T raw_value = 0;
+    memcpy(&raw_value, &frame.data[cfg.start_bit / 8], sizeof(T));
+    return raw_value * cfg.scale + cfg.offset;
+}
+
+static double legacy_parse_value(const can_frame& frame, const ChannelConfig& cfg) {
+    bool is_signed = cfg.type == SignalType::SIGNED;
+    switch (cfg.bit_length) {
+        case 8:  return is_signed ? legacy_extract<int8_t>(frame, cfg) : legacy_extract<uint8_t>(frame, cfg);
+        case 16: return is_signed ? legacy_extract<int16_t>(frame, cfg) : legacy_extract<uint16_t>(frame, cfg);
+        case 32: return is_signed ? legacy_extract<int32_t>(frame, cfg) : legacy_extract<uint32_t>(frame, cfg);
+    }
+    return legacy_extract<double>(frame, cfg);
+}
+
+static bool known_values() {
+    can_frame f{};
+    f.can_dlc = 8;
+    const uint8_t data[8] = {0x34, 0x12, 0xAB, 0xCD, 0x80, 0x01, 0x00, 0xFF};
+    memcpy(f.data, data, sizeof(data));
+
+    ChannelConfig c = make_channel("c", 0, 12, ByteOrder::INTEL, SignalType::UNSIGNED);
+    bool ok = true;
+
+    ok &= check("intel 12-bit", parse_value(f, c), 0x234);
+    c.start_bit = 12; c.bit_length = 1;
+    ok &= check("intel 1-bit flag", parse_value(f, c), 1);
+    c.start_bit = 12; c.bit_length = 4; c.type = SignalType::SIGNED;
+    ok &= check("intel 4-bit signed", parse_value(f, c), 1);
+    c.start_bit = 56; c.bit_length = 8;
+    ok &= check("intel 8-bit signed", parse_value(f, c), -1);
+
+    // Motorola 16-bit at byte 2: 0xABCD
+    c.byte_order = ByteOrder::MOTOROLA; c.type = SignalType::UNSIGNED;
+    c.start_bit = 23; c.bit_length = 16;
+    ok &= check("motorola 16-bit", parse_value(f, c), 0xABCD);
+    // Motorola 12-bit signed starting at the MSB of byte 2: 0xABC -> -1348
+    c.bit_length = 12; c.type = SignalType::SIGNED;
+    ok &= check("motorola 12-bit signed", parse_value(f, c), -1348);
+    // Motorola 9-bit with its MSB at bit 0 of byte 4 (0), continuing through byte 5 (0x01)
+    c.start_bit = 32; c.bit_length = 9; c.type = SignalType::UNSIGNED;
+    ok &= check("motorola 9-bit", parse_value(f, c), 0x01);
+
+    // compiled path must agree with parse_value bit for bit
+    FrameMap frames = make_frame_map(false);
+    FrameDecoder decoder(frames);
+    for (const auto& [can_id, channels] : frames) {
+        f.can_id = can_id;
+        decoder.decode(f, [&](const DecodeEntry& entry, double value) {
+            const ChannelConfig& cfg = decoder.channel(entry.channel);
+            ok &= check(cfg.name.c_str(), value, parse_value(f, cfg));
+        });
+    }
+    return ok;
+}
+
+// bit-at-a-time reference: Intel counts up from the start bit, Motorola walks down from the MSB
+static uint64_t reference_raw(const uint8_t* data, const ChannelConfig& cfg) {
+    uint64_t raw = 0;
+    int pos = cfg.start_bit;
+    for (int i = 0; i < cfg.bit_length; ++i) {
+        if (cfg.byte_order == ByteOrder::INTEL) {
+            int bit = cfg.start_bit + i;
+            raw |= static_cast<uint64_t>((data[bit / 8] >> (bit % 8)) & 1) << i;
+        } else {
+            raw = (raw << 1) | ((data[pos / 8] >> (pos % 8)) & 1);
+            pos = pos % 8 == 0 ? pos + 15 : pos - 1;
+        }
+    }
+    return raw;
+}
+
+// every unsigned signal position and length that fits a 64-byte payload, through
+// parse_value and the decoder, plus a short FD frame that must skip the signals past its end
+static bool fd_known_values() {
+    canfd_frame f{};
+    f.can_id = 0x200;
+    f.len = CANFD_MAX_DLEN;
+    for (int i = 0; i < CANFD_MAX_DLEN; ++i) f.data[i] = static_cast<uint8_t>(i * 37 + 11);
+
+    bool ok = true;
+    long checked = 0;
+    for (ByteOrder order : {ByteOrder::INTEL, ByteOrder::MOTOROLA}) {
+        for (int length : {1, 7, 12, 16, 31, 57}) {
+            for (int start = 0; start < CANFD_MAX_DLEN * 8; ++start) {
+                ChannelConfig c = make_channel("fd", start, length, order, SignalType::UNSIGNED);
+                c.frame_bytes = CANFD_MAX_DLEN;
+                try {
+                    make_bit_plan(c);
+                } catch (const std::invalid_argument&) {
+                    continue;
+                }
+                double want = static_cast<double>(reference_raw(f.data, c));
+                if (parse_value(f, c) != want) {
+                    char what[64];
+                    snprintf(what, sizeof(what), "fd %s %d-bit at %d",
+                             order == ByteOrder::INTEL ? "intel" : "motorola", length, start);
+                    ok &= check(what, parse_value(f, c), want);
+                }
+                ++checked;
+            }
+        }
+    }
+
+    // a 64-byte message with signals spread over every window, some straddling two
+    FrameMap frames;
+    auto& channels = frames[f.can_id];
+    for (int n = 0; n < 24; ++n) {
+        ByteOrder order = n % 3 == 2 ? ByteOrder::MOTOROLA : ByteOrder::INTEL;
+        int start = order == ByteOrder::INTEL ? n * 21 : (n * 21) / 8 * 8 + 7;
+        channels.push_back(make_channel("fd_" + std::to_string(n), start, 13, order,
+                                        n % 2 ? SignalType::SIGNED : SignalType::UNSIGNED));
+        channels.back().frame_bytes = CANFD_MAX_DLEN;
+    }
+    FrameDecoder decoder(frames);
+    uint32_t decoded = decoder.decode(f, [&](const DecodeEntry& entry, double value) {
+        const ChannelConfig& cfg = decoder.channel(entry.channel);
+        ok &= check(cfg.name.c_str(), value, parse_value(f, cfg));
+    });
+    ok &= check("fd signals decoded", decoded, channels.size());
+
+    // 16 bytes received: only signals ending inside them come out
+    f.len = 16;
+    std::size_t fit = 0;
+    for (const auto& cfg : channels) fit += make_bit_plan(cfg).end <= 16;
+    decoded = decoder.decode(f, [&](const DecodeEntry& entry, double) {
+        ok &= make_bit_plan(decoder.channel(entry.channel)).end <= 16;
+    });
+    ok &= check("short fd frame", decoded, fit);
+
+    printf("fd payloads: %ld signal layouts checked\n", checked);
+    return ok;
+}
+
+// one 64-byte FD message with `signals` 16-bit signals packed from byte 0
+static FrameMap make_fd_map(int signals) {
+    FrameMap frames;
+    auto& channels = frames[0x200];
+    for (int n = 0; n < signals; ++n) {
+        ByteOrder order = n % 2 ? ByteOrder::MOTOROLA : ByteOrder::INTEL;
+        int start = order == ByteOrder::INTEL ? n * 16 : n * 16 + 7;
+        channels.push_back(make_channel("fd_" + std::to_string(n), start, 16, order, SignalType::SIGNED));
+        channels.back().frame_bytes = CANFD_MAX_DLEN;
+    }
+    return frames;
+}
+
+// BMS cell temperatures: 96 cells over 16 pages of 6, selected by the first byte
+static const uint32_t MUX_ID = 0x620;
+static const int MUX_PAGES = 16;
+static const int CELLS_PER_PAGE = 6;
+
+static FrameMap load_mux_dbc() {
+    char path[] = "/tmp/decode_bench_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd == -1) return {};
+    ::close(fd);
+
+    std::ofstream out(path);
+    out << "BO_ " << MUX_ID << " BMS_Temps: 8 BMS\n";
+    out << " SG_ temp_page M : 0|8@1+ (1,0) [0|15] \"\" Vector__XXX\n";
+    for (int page = 0; page < MUX_PAGES; ++page) {
+        for (int k = 0; k < CELLS_PER_PAGE; ++k) {
+            out << " SG_ cell_" << page * CELLS_PER_PAGE + k << " m" << page << " : " << 8 + 8 * k
+                << "|8@1+ (0.5,-20) [-20|107.5] \"degC\" Vector__XXX\n";
+        }
+    }
+    out.close();
+
+    FrameMap frames = load_dbc_config(path);
+    unlink(path);
+    return frames;
+}
+
+static can_frame mux_frame(uint8_t page, uint8_t seed) {
+    can_frame f{};
+    f.can_id = MUX_ID;
+    f.can_dlc = 8;
+    f.data[0] = page;
+    for (int k = 1; k < 8; ++k) f.data[k] = static_cast<uint8_t>(seed + k * 13);
+    return f;
+}
+
+// what decoding looks like without a page table: evaluate the selector, then test every signal
+static uint32_t naive_mux_decode(const can_frame& f, const std::vector<ChannelConfig>& channels,
+                                 const ChannelConfig& selector, double& sum) {
+    uint32_t decoded = 0;
+    double page = parse_value(f, selector);
+    for (const auto& cfg : channels) {
+        if (cfg.mux == MuxRole::MULTIPLEXED && cfg.mux_value != page) continue;
+        sum += parse_value(f, cfg);
+        ++decoded;
+    }
+    return decoded;
+}
+
+static bool mux_known_values(const FrameMap& frames) {
+    auto it = frames.find(MUX_ID);
+    if (it == frames.end() || it->second.size() != 1 + MUX_PAGES * CELLS_PER_PAGE) {
+        printf("FAIL mux dbc: expected %d signals\n", 1 + MUX_PAGES * CELLS_PER_PAGE);
+        return false;
+    }
+    const auto& channels = it->second;
+    bool ok = check("multiplexor role", channels[0].mux == MuxRole::MULTIPLEXOR, 1);
+    ok &= check("page of cell_95", channels.back().mux_value, MUX_PAGES - 1);
+
+    FrameDecoder decoder(frames);
+    for (int page = 0; page < MUX_PAGES; ++page) {
+        can_frame f = mux_frame(static_cast<uint8_t>(page), static_cast<uint8_t>(page * 7));
+        uint32_t decoded = decoder.decode(f, [&](const DecodeEntry& entry, double value) {
+            const ChannelConfig& cfg = decoder.channel(entry.channel);
+            if (cfg.mux == MuxRole::MULTIPLEXED) ok &= check("cell page", cfg.mux_value, page);
+            ok &= check(cfg.name.c_str(), value, parse_value(f, cfg));
+        });
+        ok &= check("signals per page", decoded, 1 + CELLS_PER_PAGE);
+    }
+
+    // unconfigured page: only the multiplexor itself
+    can_frame f = mux_frame(200, 0);
+    ok &= check("unknown page", decoder.decode(f, [](const DecodeEntry&, double) {}), 1);
+
+    // m<n> signals without an M selector are a config error
+    FrameMap orphan;
+    orphan[0x100].push_back(channels[1]);
+    try {
+        FrameDecoder bad(orphan);
+        ok &= check("orphan multiplexed signal rejected", 0, 1);
+    } catch (const std::invalid_argument&) {}
+    return ok;
+}
+
+template <typename Fn>
+static double time_ns(long total, Fn fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < total; ++i) fn(i);
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e9 / total;
+}
+
+int main(int argc, char* argv[]) {
+    long total = (argc > 1) ? std::atol(argv[1]) : 10000000;
+
+    FrameMap mux_map = load_mux_dbc();
+    if (!known_values() || !fd_known_values() || !mux_known_values(mux_map)) return 1;
+
+    FrameMap frame_map = make_frame_map(true);
+    FrameDecoder decoder(frame_map);
+    FrameMap bit_map = make_frame_map(false);
+    FrameDecoder bit_decoder(bit_map);
+
+    // mix of configured IDs and unknown bus traffic
+    std::vector<uint32_t> ids;
+    for (const auto& [can_id, channels] : frame_map) ids.push_back(can_id);
+    for (uint32_t n = 0; n < 40; ++n) ids.push_back(0x600 + n);
+
+    std::mt19937 rng(42);
+    std::vector<can_frame> frames(4096);
+    for (auto& f : frames) {
+        f.can_id = ids[rng() % ids.size()];
+        f.can_dlc = 8;
+        for (auto& b : f.data) b = static_cast<uint8_t>(rng());
+    }
+    auto frame_at = [&](long i) -> const can_frame& { return frames[i & (frames.size() - 1)]; };
+
+    double sum_map = 0.0, sum_legacy = 0.0, sum_dec = 0.0, sum_bits = 0.0;
+
+    double t_map = time_ns(total, [&](long i) {
+        const can_frame& frame = frame_at(i);
+        auto it = frame_map.find(frame.can_id);
+        if (it == frame_map.end()) return;
+        for (const auto& cfg : it->second) sum_map += parse_value(frame, cfg);
+    });
+    double t_legacy = time_ns(total, [&](long i) {
+        const can_frame& frame = frame_at(i);
+        auto it = frame_map.find(frame.can_id);
+        if (it == frame_map.end()) return;
+        for (const auto& cfg : it->second) sum_legacy += legacy_parse_value(frame, cfg);
+    });
+    double t_dec = time_ns(total, [&](long i) {
+        decoder.decode(frame_at(i), [&](const DecodeEntry&, double value) { sum_dec += value; });
+    });
+    double t_bits = time_ns(total, [&](long i) {
+        bit_decoder.decode(frame_at(i), [&](const DecodeEntry&, double value) { sum_bits += value; });
+    });
+
+    printf("map + parse_value          %8.2f ns/frame\n", t_map);
+    printf("map + memcpy extract<T>    %8.2f ns/frame\n", t_legacy);
+    printf("FrameDecoder               %8.2f ns/frame\n", t_dec);
+    printf("FrameDecoder, bit signals  %8.2f ns/frame (checksum %f)\n", t_bits, sum_bits);
+
+    // per-frame decoder cost should grow much slower than the per-signal parse_value path
+    std::vector<canfd_frame> fd_frames(256);
+    for (auto& f : fd_frames) {
+        f.can_id = 0x200;
+        f.len = CANFD_MAX_DLEN;
+        for (auto& b : f.data) b = static_cast<uint8_t>(rng());
+    }
+    auto fd_at = [&](long i) -> const canfd_frame& { return fd_frames[i & (fd_frames.size() - 1)]; };
+
+    printf("\n64-byte CAN FD     parse_value ns/frame   FrameDecoder ns/frame   ns/signal\n");
+    for (int signals : {4, 16, 32}) {
+        FrameMap fd_map = make_fd_map(signals);
+        FrameDecoder fd_decoder(fd_map);
+        const auto& channels = fd_map.begin()->second;
+        double sum_parse = 0.0, sum_fd = 0.0;
+
+        double t_parse = time_ns(total / 4, [&](long i) {
+            const canfd_frame& frame = fd_at(i);
+            auto it = fd_map.find(frame.can_id);
+            if (it == fd_map.end()) return;
+            for (const auto& cfg : channels) sum_parse += parse_value(frame, cfg);
+        });
+        double t_fd = time_ns(total / 4, [&](long i) {
+            fd_decoder.decode(fd_at(i), [&](const DecodeEntry&, double value) { sum_fd += value; });
+        });
+        printf("%2d signals          %8.2f               %8.2f                %6.2f\n",
+               signals, t_parse, t_fd, t_fd / signals);
+        if (sum_parse != sum_fd) {
+            printf("FAIL fd checksum with %d signals\n", signals);
+            return 1;
+        }
+    }
+
+    // 96 multiplexed cells: the page table decodes 7 signals per frame, the naive path tests 97
+    std::vector<can_frame> mux_frames(256);
+    for (std::size_t i = 0; i < mux_frames.size(); ++i) {
+        mux_frames[i] = mux_frame(static_cast<uint8_t>(i % MUX_PAGES), static_cast<uint8_t>(rng()));
+    }
+    auto mux_at = [&](long i) -> const can_frame& { return mux_frames[i & (mux_frames.size() - 1)]; };
+    FrameDecoder mux_decoder(mux_map);
+    const auto& mux_channels = mux_map.at(MUX_ID);
+    double sum_naive = 0.0, sum_mux = 0.0;
+
+    double t_naive = time_ns(total / 4, [&](long i) {
+        naive_mux_decode(mux_at(i), mux_channels, mux_channels[0], sum_naive);
+    });
+    double t_mux = time_ns(total / 4, [&](long i) {
+        mux_decoder.decode(mux_at(i), [&](const DecodeEntry&, double value) { sum_mux += value; });
+    });
+    printf("\nmultiplexed, 96 cells  test every signal %8.2f ns/frame   page table %8.2f ns/frame\n",
+           t_naive, t_mux);
+    if (sum_naive != sum_mux) {
+        printf("FAIL mux checksum\n");
+        return 1;
+    }
+
+    bool match = sum_map == sum_dec && sum_legacy == sum_dec;
+    printf("checksum %s\n", match ? "match" : "MISMATCH");
+    return match ? 0 : 1;
+}
@@ -0,0 +1,195 @@
+// derived channels: checks compiled expressions against the same math in C++, that only channels
+// with a changed input run, and times evaluation per derived channel against hand-written code
+// usage: derived_bench [updates]
+
+#include <linux/can.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <vector>
+
+#include "derived_channels.hpp"
+#include "signal_table.hpp"
+#include "bench_util.hpp"
+
+enum Input { VOLTAGE, CURRENT, WHEEL_FL, WHEEL_FR, WHEEL_RL, WHEEL_RR, BRAKE_F, BRAKE_R, INPUTS };
+
+static const char* const input_names[INPUTS] = {
+    "pack_voltage", "pack_current", "wheel_fl", "wheel_fr", "wheel_rl", "wheel_rr", "brake_front", "brake_rear"};
+
+// two buses; "temp" appears in two frames so it needs @<id>
+static std::vector<FrameMap> make_frames(SignalTable& signals) {
+    std::vector<FrameMap> maps(2);
+    maps[0][0x100] = {make_channel(input_names[VOLTAGE], 0), make_channel(input_names[CURRENT], 16),
+                      make_channel("temp", 32)};
+    maps[0][0x101] = {make_channel("temp", 0)};
+    maps[1][0x200] = {make_channel(input_names[WHEEL_FL], 0), make_channel(input_names[WHEEL_FR], 16),
+                      make_channel(input_names[WHEEL_RL], 32), make_channel(input_names[WHEEL_RR], 48)};
+    maps[1][0x18FF0300u | CAN_EFF_FLAG] = {make_channel(input_names[BRAKE_F], 0), make_channel(input_names[BRAKE_R], 16)};
+    for (auto& frames : maps) intern_signals(frames, signals);
+    return maps;
+}
+
+static const std::vector<DerivedConfig> derived_config = {
+    {"pack_power", "pack_voltage * pack_current / 1000"},
+    {"wheel_avg", "(wheel_fl + wheel_fr + wheel_rl + wheel_rr) / 4"},
+    {"front_avg", "(wheel_fl + wheel_fr) / 2"},
+    {"slip_ratio", "((wheel_rl + wheel_rr) / 2 - front_avg) / front_avg"},
+    {"brake_bias", "100 * brake_front@18FF0300 / (brake_front + brake_rear)"},
+    {"temp_delta", "abs(temp@100 - temp@0x101) * (2 * 0.5)"},
+};
+
+// the same math, written out
+static double native(int channel, const double* in, double front_avg, double temp_a, double temp_b) {
+    switch (channel) {
+        case 0: return in[VOLTAGE] * in[CURRENT] / 1000;
+        case 1: return (in[WHEEL_FL] + in[WHEEL_FR] + in[WHEEL_RL] + in[WHEEL_RR]) / 4;
+        case 2: return (in[WHEEL_FL] + in[WHEEL_FR]) / 2;
+        case 3: return ((in[WHEEL_RL] + in[WHEEL_RR]) / 2 - front_avg) / front_avg;
+        case 4: return 100 * in[BRAKE_F] / (in[BRAKE_F] + in[BRAKE_R]);
+        case 5: return std::fabs(temp_a - temp_b) * (2 * 0.5);
+    }
+    return 0.0;
+}
+
+struct Feed {
+    std::vector<TelemetryMessage> msgs;
+    std::vector<uint64_t> wall;
+
+    void add(uint16_t signal_id, double value, uint64_t stamp) {
+        msgs.push_back(TelemetryMessage{signal_id, 0, 0, value, stamp});
+        wall.push_back(stamp);
+    }
+    void clear() { msgs.clear(); wall.clear(); }
+};
+
+static bool rejects(const std::vector<FrameMap>& maps, SignalTable& signals, const char* expr) {
+    try {
+        DerivedEngine engine({{"bad", expr}}, maps, signals);
+    } catch (const std::invalid_argument&) {
+        return true;
+    }
+    printf("FAIL accepted '%s'\n", expr);
+    return false;
+}
+
+int main(int argc, char* argv[]) {
+    long total = (argc > 1) ? std::atol(argv[1]) : 2000000;
+
+    static SignalTable signals;
+    std::vector<FrameMap> maps = make_frames(signals);
+    uint16_t ids[INPUTS];
+    for (int i = 0; i < INPUTS; ++i) {
+        uint32_t can_id = i < 2 ? 0x100 : i < 6 ? 0x200 : (0x18FF0300u | CAN_EFF_FLAG);
+        ids[i] = signals.find(can_id, input_names[i]);
+    }
+    uint16_t temp_a = signals.find(0x100, "temp"), temp_b = signals.find(0x101, "temp");
+
+    DerivedEngine engine(derived_config, maps, signals);
+    std::vector<TelemetryMessage> out;
+    std::vector<uint64_t> out_wall;
+    Feed feed;
+    bool ok = true;
+
+    // nothing runs until every operand has been seen
+    double in[INPUTS] = {400.0, 120.0, 30.0, 31.0, 33.0, 32.0, 60.0};
+    for (int i = 0; i < BRAKE_R; ++i) feed.add(ids[i], in[i], 100 + i);
+    feed.add(temp_a, 45.0, 200);
+    engine.update(feed.msgs.data(), feed.wall.data(), feed.msgs.size());
+    ok &= check("channels run without brake_rear / temp@101", engine.evaluate(out, out_wall), 4);
+
+    in[BRAKE_R] = 40.0;
+    feed.clear();
+    feed.add(ids[BRAKE_R], in[BRAKE_R], 300);
+    feed.add(temp_b, 41.5, 301);
+    engine.update(feed.msgs.data(), feed.wall.data(), feed.msgs.size());
+    ok &= check("remaining channels run", engine.evaluate(out, out_wall), 2);
+
+    double front_avg = native(2, in, 0, 0, 0);
+    for (const auto& msg : out) {
+        std::size_t c = 0;
+        while (engine.signal_id(c) != msg.signal_id) ++c;
+        ok &= check(engine.name(c).c_str(), msg.value, native(static_cast<int>(c), in, front_avg, 45.0, 41.5));
+        const SignalInfo* info = signals.info(msg.signal_id);
+        ok &= check("derived CAN ID", info ? info->can_id : 0, DERIVED_CAN_ID);
+    }
+    ok &= check("brake_bias stamped with brake_rear", out[out.size() - 2].ingest_ns, 300);
+    ok &= check("temp_delta stamped with temp@101", out.back().ingest_ns, 301);
+
+    // unchanged inputs run nothing; one changed input runs only its readers
+    out.clear();
+    out_wall.clear();
+    engine.update(feed.msgs.data(), feed.wall.data(), feed.msgs.size());
+    ok &= check("unchanged inputs", engine.evaluate(out, out_wall), 0);
+    feed.clear();
+    feed.add(ids[CURRENT], 125.0, 400);
+    engine.update(feed.msgs.data(), feed.wall.data(), feed.msgs.size());
+    ok &= check("one input changed", engine.evaluate(out, out_wall), 1);
+
+    // front wheels stopped: slip ratio divides by zero and is held back, its readers untouched
+    out.clear();
+    out_wall.clear();
+    feed.clear();
+    feed.add(ids[WHEEL_FL], 0.0, 500);
+    feed.add(ids[WHEEL_FR], 0.0, 500);
+    engine.update(feed.msgs.data(), feed.wall.data(), feed.msgs.size());
+    ok &= check("runs with stopped wheels", engine.evaluate(out, out_wall), 3);
+    ok &= check("non-finite slip ratio not published", out.size(), 2);
+
+    ok &= rejects(maps, signals, "temp * 2");
+    ok &= rejects(maps, signals, "no_such_signal + 1");
+    ok &= rejects(maps, signals, "pack_voltage *");
+    ok &= rejects(maps, signals, "pow(pack_voltage, 2)");
+    ok &= rejects(maps, signals, "2 * 3");
+    ok &= rejects(maps, signals, "(pack_voltage");
+    if (!ok) return 1;
+    printf("%zu derived channels compiled to %zu instructions\n", engine.channel_count(), engine.instruction_count());
+
+    // rotate through the inputs changing one value per update, as frames from the bus would
+    const int per_batch = 16;
+    std::vector<Feed> batches(64);
+    for (std::size_t b = 0; b < batches.size(); ++b) {
+        for (int k = 0; k < per_batch; ++k) {
+            int i = static_cast<int>((b * per_batch + k) % INPUTS);
+            batches[b].add(ids[i], 10.0 + static_cast<double>((b * per_batch + k) % 97), b);
+        }
+    }
+
+    std::size_t ran = 0;
+    double sink = 0.0;
+    auto start = std::chrono::steady_clock::now();
+    for (long n = 0; n < total / per_batch; ++n) {
+        const Feed& batch = batches[n % batches.size()];
+        out.clear();
+        out_wall.clear();
+        engine.update(batch.msgs.data(), batch.wall.data(), batch.msgs.size());
+        ran += engine.evaluate(out, out_wall);
+        if (!out.empty()) sink += out.front().value;
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // hand-written equivalent: the same channels recomputed on every input message
+    double values[INPUTS] = {};
+    double native_sink = 0.0;
+    auto native_start = std::chrono::steady_clock::now();
+    for (long n = 0; n < total / per_batch; ++n) {
+        const Feed& batch = batches[n % batches.size()];
+        for (const auto& msg : batch.msgs) {
+            for (int i = 0; i < INPUTS; ++i) if (ids[i] == msg.signal_id) values[i] = msg.value;
+        }
+        double fa = native(2, values, 0, 0, 0);
+        for (int c = 0; c < 5; ++c) native_sink += native(c, values, fa, 45.0, 41.5);
+    }
+    double native_secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - native_start).count();
+
+    long messages = total / per_batch * per_batch;
+    printf("%ld input messages, %zu channel runs\n", messages, ran);
+    printf("engine   %8.2f ns/input message  %8.2f ns per derived channel run (update + evaluate)\n",
+           secs * 1e9 / messages, secs * 1e9 / ran);
+    printf("native   %8.2f ns/input message  (checksums %g / %g)\n",
+           native_secs * 1e9 / messages, sink, native_sink);
+    printf("PASS\n");
+    return 0;
+}
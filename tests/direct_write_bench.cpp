@@ -0,0 +1,180 @@
+// log write paths compared: fwrite + fflush per chunk (the logger before its I/O thread),
+// write(2) through the page cache (LogWriter's fallback) and UringWriter (O_DIRECT via io_uring)
+// each writes the same data in LOG_WRITE_ALIGN chunks, like the logger's I/O thread under
+// backlog, then makes it durable (fsync for the buffered paths); reports how long each call
+// blocks the writing thread (p50/p99/max), the submit -> completion time of direct writes,
+// total time and CPU time, and checks the direct file reads back byte for byte, also when it is
+// written in odd-sized appends with a sync_tail() after each
+// usage: direct_write_bench [dir] [MiB] [MiB/s, 0 = as fast as possible]
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <sys/resource.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "log_writer.hpp"
+#include "uring_writer.hpp"
+#include "bench_util.hpp"
+
+static constexpr std::size_t CHUNK = LOG_WRITE_ALIGN;
+static constexpr std::size_t ODD_TAIL = 1000;   // ends the data off a block boundary
+
+static double cpu_seconds() {
+    rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+}
+
+struct Result {
+    LatencyHistogram call;
+    double wall_s = 0;
+    double cpu_s = 0;
+};
+
+// calls write_chunk(data, len) for every chunk of `total` bytes, paced to `rate` bytes/s, then finish()
+template <typename Write, typename Finish>
+static void run(Result& r, const std::vector<uint8_t>& data, double rate, Write write_chunk, Finish finish) {
+    double cpu0 = cpu_seconds();
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t at = 0; at < data.size(); at += CHUNK) {
+        if (rate > 0) std::this_thread::sleep_until(start + std::chrono::duration<double>(at / rate));
+        std::size_t len = std::min(CHUNK, data.size() - at);
+        uint64_t t0 = monotonic_ns();
+        write_chunk(data.data() + at, len);
+        r.call.record_since(t0, monotonic_ns());
+    }
+    finish();
+    r.wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    r.cpu_s = cpu_seconds() - cpu0;
+}
+
+static void report(const char* what, const Result& r, std::size_t bytes) {
+    LatencySummary s = r.call.summary();
+    printf("%-22s call p50 %8.1f us  p99 %8.1f us  max %8.1f us   %6.2f s  %6.1f MiB/s  cpu %5.2f s (%4.1f ms/MiB)\n",
+           what, s.p50_ns / 1e3, s.p99_ns / 1e3, s.max_ns / 1e3, r.wall_s, bytes / r.wall_s / 1048576.0, r.cpu_s,
+           r.cpu_s * 1e3 / (bytes / 1048576.0));
+}
+
+int main(int argc, char* argv[]) {
+    std::string dir = (argc > 1) ? argv[1] : "/tmp";
+    std::size_t mib = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 256;
+    double rate = (argc > 3) ? std::atof(argv[3]) * 1048576.0 : 0.0;
+    std::string path = dir + "/direct_write_bench." + std::to_string(getpid());
+
+    std::vector<uint8_t> data(mib * 1048576 + ODD_TAIL);
+    uint64_t x = 0x9E3779B97F4A7C15ull;
+    for (uint8_t& b : data) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        b = static_cast<uint8_t>(x);
+    }
+    printf("%zu MiB to %s in %zu KiB writes, %s\n", mib, dir.c_str(), CHUNK / 1024,
+           rate > 0 ? (std::to_string(static_cast<int>(rate / 1048576)) + " MiB/s").c_str() : "unpaced");
+
+    Result fwrite_r;
+    {
+        FILE* f = fopen(path.c_str(), "wb");
+        if (!f) {
+            std::perror(path.c_str());
+            return 1;
+        }
+        run(fwrite_r, data, rate,
+            [&](const uint8_t* p, std::size_t len) {
+                fwrite(p, 1, len, f);
+                fflush(f);
+            },
+            [&] {
+                fsync(fileno(f));
+                fclose(f);
+            });
+        unlink(path.c_str());
+    }
+    report("fwrite + fflush", fwrite_r, data.size());
+
+    Result write_r;
+    {
+        int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        run(write_r, data, rate,
+            [&](const uint8_t* p, std::size_t len) {
+                if (::write(fd, p, len) != static_cast<ssize_t>(len)) std::perror("write");
+            },
+            [&] {
+                fsync(fd);
+                close(fd);
+            });
+        unlink(path.c_str());
+    }
+    report("write(2)", write_r, data.size());
+
+    bool ok = true;
+    Result direct_r;
+    LatencyHistogram completion;
+    {
+        UringWriter direct(path, &completion);
+        if (!direct.is_open()) {
+            printf("O_DIRECT via io_uring unavailable on %s: skipped (LogWriter falls back to write(2))\n",
+                   dir.c_str());
+            unlink(path.c_str());
+            printf("PASS\n");
+            return 0;
+        }
+        std::size_t chunks = 0;
+        run(direct_r, data, rate,
+            [&](const uint8_t* p, std::size_t len) {
+                direct.append(p, len);
+                // the logger syncs its tail whenever it catches up: do it now and then here too
+                if (++chunks % 64 == 0) direct.sync_tail();
+                direct.reap();
+            },
+            [&] { direct.close(); });
+        ok &= expect("no write errors", direct.errors() == 0);
+    }
+    report("io_uring + O_DIRECT", direct_r, data.size());
+    LatencySummary c = completion.summary();
+    printf("%-22s      p50 %8.1f us  p99 %8.1f us  max %8.1f us   (%llu writes of up to %zu KiB)\n",
+           "  submit -> complete", c.p50_ns / 1e3, c.p99_ns / 1e3, c.max_ns / 1e3,
+           static_cast<unsigned long long>(c.count), DIRECT_CHUNK / 1024);
+
+    // read back: same bytes, tail padding trimmed
+    std::vector<uint8_t> back(data.size() + DIRECT_ALIGN);
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    std::size_t got = 0;
+    for (ssize_t n; fd >= 0 && (n = read(fd, back.data() + got, back.size() - got)) > 0;) got += static_cast<std::size_t>(n);
+    if (fd >= 0) close(fd);
+    unlink(path.c_str());
+    ok &= expect("file is exactly the data written", got == data.size() && memcmp(back.data(), data.data(), got) == 0);
+
+    // odd-sized appends with a sync after each: every sync rewrites the block the last one ended in
+    {
+        UringWriter direct(path);
+        std::size_t len = std::min(data.size(), 2 * DIRECT_CHUNK + ODD_TAIL);
+        for (std::size_t at = 0, step = 1; at < len; at += step, step = step * 3 % 7919) {
+            direct.append(data.data() + at, std::min(step, len - at));
+            direct.sync_tail();
+            direct.reap();
+        }
+        direct.close();
+        ok &= expect("no write errors syncing odd appends", direct.errors() == 0);
+        fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        got = 0;
+        for (ssize_t n; fd >= 0 && (n = read(fd, back.data() + got, back.size() - got)) > 0;) got += static_cast<std::size_t>(n);
+        if (fd >= 0) close(fd);
+        unlink(path.c_str());
+        ok &= expect("odd appends read back exactly", got == len && memcmp(back.data(), data.data(), got) == 0);
+    }
+
+    if (!ok) {
+        printf("FAIL\n");
+        return 1;
+    }
+    printf("PASS\n");
+    return 0;
+}
@@ -0,0 +1,179 @@
+// LogWriter against a card that stops taking writes: the log goes to a FIFO whose reader
+// pauses, so the I/O thread blocks in write() exactly as on a stalled SD card
+// the consume side is fed a full bus (256 samples every 10 ms) and must keep its per-batch
+// cost flat through a stall the arenas can absorb, count (not wait out) samples past one they
+// can't, and afterwards the file must decode to exactly the samples that weren't counted lost
+// usage: log_writer_bench [stall seconds]
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "log_writer.hpp"
+#include "bench_util.hpp"
+
+static constexpr std::size_t BATCH = 256;
+static constexpr uint16_t SIGNALS = 64;
+
+// messages carry only a signal ID; the writer finds the CAN ID here
+static uint32_t can_id_of(uint16_t signal_id) { return 0x100 + signal_id % 16; }
+static constexpr auto BATCH_PERIOD = std::chrono::milliseconds(10);
+
+// drains the FIFO into memory unless paused
+struct Card {
+    int fd;
+    std::vector<uint8_t> data;
+    std::atomic<bool> paused{false};
+    std::thread thread;
+
+    explicit Card(int fd_) : fd(fd_) {
+        thread = std::thread([this] {
+            uint8_t buf[65536];
+            for (;;) {
+                if (paused.load(std::memory_order_relaxed)) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    continue;
+                }
+                ssize_t n = read(fd, buf, sizeof(buf));
+                if (n > 0) data.insert(data.end(), buf, buf + n);
+                else if (n == 0) break;    // writer closed
+                else std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+    }
+};
+
+struct Feed {
+    LogWriter& writer;
+    uint64_t next = 0;                  // value of the next sample
+    LatencyHistogram batch_cost;
+
+    // `seconds` of traffic at `rate` times the bus rate, batches paced in real time
+    void run(double seconds, int rate) {
+        auto period = BATCH_PERIOD / rate;
+        auto start = std::chrono::steady_clock::now();
+        TelemetryMessage msgs[BATCH];
+        for (long b = 0; b < static_cast<long>(seconds * 1000 / 10 * rate); ++b) {
+            std::this_thread::sleep_until(start + b * period);
+            uint64_t now = monotonic_ns();
+            for (std::size_t i = 0; i < BATCH; ++i, ++next) {
+                msgs[i] = TelemetryMessage{static_cast<uint16_t>(i % SIGNALS), 0, 0, static_cast<double>(next), now};
+            }
+            uint64_t t0 = monotonic_ns();
+            writer.stage(msgs, BATCH);
+            writer.write_staged(0);
+            writer.flush();
+            batch_cost.record_since(t0, monotonic_ns());
+        }
+    }
+};
+
+static void print_cost(const char* what, const LatencyHistogram& h) {
+    LatencySummary s = h.summary();
+    printf("  %-30s p50 %7.1f us  p99 %7.1f us  max %7.1f us\n", what, s.p50_ns / 1e3, s.p99_ns / 1e3, s.max_ns / 1e3);
+}
+
+int main(int argc, char* argv[]) {
+    double stall = (argc > 1) ? std::atof(argv[1]) : 2.0;
+    std::string path = "/tmp/log_writer_bench." + std::to_string(getpid());
+    if (mkfifo(path.c_str(), 0600) != 0) {
+        std::perror("mkfifo");
+        return 1;
+    }
+    int card_fd = open(path.c_str(), O_RDONLY | O_NONBLOCK);
+    bool ok = true;
+
+    static LoggerStats stats;
+    static SignalTable signals;
+    for (uint16_t id = 0; id < SIGNALS; ++id) signals.intern(can_id_of(id), "sig" + std::to_string(id));
+    std::unique_ptr<Card> card;
+    uint64_t lost_in_stall, lost_in_overload;
+    uint64_t pushed;
+    {
+        LogWriter writer(stats, &signals, path);
+        // only once the writer has the FIFO open, before that a read returns end of file
+        card = std::make_unique<Card>(card_fd);
+        Feed feed{writer, 0, {}};
+
+        printf("full bus, card keeping up:\n");
+        feed.run(1.0, 1);
+        print_cost("consume cost per batch", feed.batch_cost);
+
+        printf("card stalled for %.1f s (%zu arenas hold %.1f s of bus):\n", stall, LOG_ARENAS,
+               LOG_ARENAS * BLOCK_SAMPLES / (BATCH * 100.0));
+        feed.batch_cost.reset();
+        card->paused = true;
+        feed.run(stall, 1);
+        card->paused = false;
+        print_cost("consume cost per batch", feed.batch_cost);
+        lost_in_stall = writer.lost();
+        LatencySummary s = feed.batch_cost.summary();
+        ok &= expect("nothing lost", lost_in_stall == 0);
+        ok &= expect("consume side never waits on the card", s.max_ns < 5000000);
+
+        feed.run(1.0, 1);    // let the backlog drain
+
+        printf("card stalled for 1 s under 10x the bus rate:\n");
+        feed.batch_cost.reset();
+        card->paused = true;
+        feed.run(1.0, 10);
+        card->paused = false;
+        print_cost("consume cost per batch", feed.batch_cost);
+        lost_in_overload = writer.lost() - lost_in_stall;
+        s = feed.batch_cost.summary();
+        printf("  %llu of %llu samples lost\n", static_cast<unsigned long long>(lost_in_overload),
+               static_cast<unsigned long long>(BATCH * 1000));
+        ok &= expect("overflow counted, not waited out", lost_in_overload > 0 && s.max_ns < 5000000);
+        ok &= expect("stats report it", stats.lost.load() == writer.lost());
+        pushed = feed.next;
+    }
+    card->thread.join();
+    close(card_fd);
+    unlink(path.c_str());
+
+    // every sample that wasn't counted lost is in the file, once
+    std::vector<uint8_t>& file = card->data;
+    std::vector<LogSample> samples;
+    std::size_t at = sizeof(LOG_FILE_MAGIC);
+    bool parsed = file.size() >= at && memcmp(file.data(), LOG_FILE_MAGIC, at) == 0;
+    while (parsed && at < file.size()) {
+        std::size_t used = decode_block(file.data() + at, file.size() - at, samples);
+        parsed = used != 0;
+        at += used;
+    }
+    std::vector<uint8_t> seen(pushed, 0);
+    std::size_t unique = 0;
+    std::size_t wrong_id = 0;
+    for (const LogSample& s : samples) {
+        auto v = static_cast<uint64_t>(s.value);
+        if (v < pushed && !seen[v]++) unique++;
+        if (s.can_id != can_id_of(s.signal_id)) wrong_id++;
+    }
+    printf("%llu pushed, %zu in the file, %llu counted lost; %llu flushes, %.1f KiB\n",
+           static_cast<unsigned long long>(pushed), samples.size(),
+           static_cast<unsigned long long>(stats.lost.load()), static_cast<unsigned long long>(stats.flushes.load()),
+           stats.bytes_written.load() / 1024.0);
+    print_cost("write() time", stats.flush_time);
+    print_cost("rx -> on disk", stats.rx_to_disk);
+    ok &= expect("file decodes", parsed);
+    ok &= expect("every sample not lost is there, once",
+                 unique == samples.size() && samples.size() + stats.lost.load() == pushed);
+    ok &= expect("CAN IDs come from the signal table", wrong_id == 0);
+
+    if (!ok) {
+        printf("FAIL\n");
+        return 1;
+    }
+    printf("PASS\n");
+    return 0;
+}
@@ -0,0 +1,131 @@
+// publish policies on a simulated 100 Hz frame: checks how many values each policy lets through
+// over a minute of synthetic time, then measures what the gates cost per frame against "always"
+// frames are synthesized in memory and fed through BusIngest (no vcan needed)
+// usage: publish_bench [frames]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "bus_reader.hpp"
+#include "bench_util.hpp"
+
+static constexpr uint32_t FRAME_ID = 0x300;
+static constexpr uint64_t PERIOD_NS = 10000000;     // 100 Hz
+static constexpr int SECONDS = 60;
+
+// counter: always; coolant: steps every 10 s, on change; cell: 20.0/20.2 noise, 0.5 deadband
+// with a 1 s heartbeat; pressure: changes every frame, at most 10 Hz
+static FrameMap make_frames(bool gated) {
+    PublishPolicy on_change, deadband, rate;
+    if (gated) {
+        on_change.mode = PublishMode::ON_CHANGE;
+        deadband.mode = PublishMode::DEADBAND;
+        deadband.deadband = 0.5;
+        deadband.heartbeat_ns = 1000000000;
+        rate.mode = PublishMode::RATE;
+        rate.min_interval_ns = 100000000;
+    }
+    FrameMap frames;
+    auto& channels = frames[FRAME_ID];
+    auto add = [&](const char* name, int start_bit, uint16_t signal_id, PublishPolicy policy) {
+        channels.push_back(make_channel(name, start_bit));
+        channels.back().scale = 0.1;
+        channels.back().signal_id = signal_id;
+        channels.back().publish = policy;
+    };
+    add("counter", 0, 0, PublishPolicy{});
+    add("coolant", 16, 1, on_change);
+    add("cell", 32, 2, deadband);
+    add("pressure", 48, 3, rate);
+    return frames;
+}
+
+static void fill_frame(CanRxFrame& rx, uint32_t n) {
+    memset(&rx, 0, sizeof(rx));
+    rx.frame.can_id = FRAME_ID;
+    rx.frame.len = 8;
+    uint16_t words[4] = {static_cast<uint16_t>(n),
+                         static_cast<uint16_t>(800 + n / 1000),
+                         static_cast<uint16_t>(n % 2 ? 202 : 200),
+                         static_cast<uint16_t>(n * 7)};
+    memcpy(rx.frame.data, words, sizeof(words));
+    // 1 ns past zero so the first frame isn't mistaken for "never published"
+    rx.rx_mono_ns = 1 + n * PERIOD_NS;
+    rx.rx_time_ns = rx.rx_mono_ns;
+}
+
+// feed `total` frames in CAN_RX_BATCH batches; returns ns per frame
+static double feed(BusIngest& ingest, uint32_t total) {
+    static CanRxFrame rx[CAN_RX_BATCH];
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t n = 0; n < total; n += CAN_RX_BATCH) {
+        int count = 0;
+        for (; count < CAN_RX_BATCH && n + count < total; ++count) fill_frame(rx[count], n + count);
+        ingest.process(rx, count);
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e9 / total;
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t timed = (argc > 1) ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 4000000;
+
+    const std::size_t capacity = 16384;
+    void* memory = aligned_alloc(64, (TelemetryQueue::bytes_for(capacity) + 63) & ~std::size_t{63});
+    TelemetryQueue* queue = TelemetryQueue::create(memory, capacity);
+    static SignalTable signals;
+    static StatsSegment stats;
+    TelemetryPublisher publisher(*queue, signals, stats.reader);
+    TraceRing trace;
+    bool ok = true;
+
+    // one minute at 100 Hz
+    {
+        BusIngest ingest(publisher, stats.reader.buses[0], trace);
+        ingest.set_decoder(std::make_unique<FrameDecoder>(make_frames(true)));
+        const uint32_t frames = SECONDS * 1000000000ull / PERIOD_NS;
+        feed(ingest, frames);
+
+        const BusStats& b = stats.reader.buses[0];
+        auto saved = [&](PublishMode m) { return b.suppressed[static_cast<int>(m)].load(); };
+        printf("%u frames, 4 signals each, over %d s:\n", frames, SECONDS);
+        ok &= expect("pushed", b.signals.load(), frames + SECONDS / 10 + SECONDS + SECONDS * 10);
+        ok &= expect("saved by on_change", saved(PublishMode::ON_CHANGE), frames - SECONDS / 10);
+        ok &= expect("saved by deadband", saved(PublishMode::DEADBAND), frames - SECONDS);
+        ok &= expect("saved by rate", saved(PublishMode::RATE), frames - SECONDS * 10);
+        ok &= expect("saved by always", saved(PublishMode::ALWAYS), 0);
+
+        // held back from the queue, but the latest-value table still has the last frame's values
+        uint32_t last = frames - 1;
+        LatestValue cell, pressure;
+        signals.read_latest(2, cell);
+        signals.read_latest(3, pressure);
+        ok &= expect("cell updates", cell.updates, frames);
+        ok &= expect("pressure updates", pressure.updates, frames);
+        ok &= expect("pressure latest x10", static_cast<uint64_t>(pressure.value * 10 + 0.5),
+                     static_cast<uint16_t>(last * 7));
+    }
+
+    // gate cost: same frames with every policy set to always, then with the mix above
+    double t_always, t_gated;
+    {
+        BusIngest ingest(publisher, stats.reader.buses[1], trace);
+        ingest.set_decoder(std::make_unique<FrameDecoder>(make_frames(false)));
+        t_always = feed(ingest, timed);
+    }
+    {
+        BusIngest ingest(publisher, stats.reader.buses[2], trace);
+        ingest.set_decoder(std::make_unique<FrameDecoder>(make_frames(true)));
+        t_gated = feed(ingest, timed);
+    }
+    printf("always      %8.2f ns/frame  %5.2f msgs/frame\n", t_always,
+           static_cast<double>(stats.reader.buses[1].signals.load()) / timed);
+    printf("policies    %8.2f ns/frame  %5.2f msgs/frame\n", t_gated,
+           static_cast<double>(stats.reader.buses[2].signals.load()) / timed);
+
+    free(memory);
+    printf("%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,114 @@
+// push throughput with 1 to 4 producer threads: the single-producer path, producers sharing it
+// behind a mutex, and a multi-producer queue; a consumer thread checks every item is intact,
+// each producer's items arrive in order, and items seen + dropped == items pushed
+// usage: queue_mp_bench [items_per_producer]
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "shared_memory.hpp"
+
+static constexpr int MAX_PRODUCERS = 4;
+
+// queue_delay_ns names the producer, value counts its items; the rest is derived so a torn copy shows
+static TelemetryMessage make_item(uint32_t producer, uint64_t n) {
+    TelemetryMessage msg;
+    msg.queue_delay_ns = producer;
+    msg.signal_id = static_cast<uint16_t>((n * 2654435761u) >> 16);
+    msg._pad = static_cast<uint16_t>(~n);
+    msg.value = static_cast<double>(n);
+    msg.ingest_ns = n ^ (static_cast<uint64_t>(producer) << 56);
+    return msg;
+}
+
+static bool intact(const TelemetryMessage& msg) {
+    if (msg.queue_delay_ns >= MAX_PRODUCERS) return false;
+    TelemetryMessage want = make_item(msg.queue_delay_ns, static_cast<uint64_t>(msg.value));
+    return msg.signal_id == want.signal_id && msg._pad == want._pad && msg.ingest_ns == want.ingest_ns;
+}
+
+enum class Mode { SINGLE, MUTEX, MULTI };
+
+struct Result {
+    double items_per_s;
+    uint64_t seen, dropped, torn, disorder;
+};
+
+static Result run(Mode mode, int producers, uint64_t per_producer) {
+    const std::size_t capacity = 16384;
+    void* memory = aligned_alloc(64, (TelemetryQueue::bytes_for(capacity) + 63) & ~std::size_t{63});
+    TelemetryQueue* queue = TelemetryQueue::create(memory, capacity, mode == Mode::MULTI);
+
+    std::atomic<int> done{0};
+    Result result{};
+    std::thread consumer([&] {
+        std::size_t pos = 0;
+        int64_t last[MAX_PRODUCERS];
+        for (auto& l : last) l = -1;
+        for (;;) {
+            bool finished = done.load(std::memory_order_acquire) == producers;
+            result.dropped += queue->consume(pos, [&](const TelemetryMessage& msg) {
+                ++result.seen;
+                if (!intact(msg)) {
+                    ++result.torn;
+                    return;
+                }
+                int64_t n = static_cast<int64_t>(msg.value);
+                if (n <= last[msg.queue_delay_ns]) ++result.disorder;
+                last[msg.queue_delay_ns] = n;
+            });
+            if (finished && pos == queue->current_pos()) break;
+        }
+    });
+
+    std::mutex mutex;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p] {
+            for (uint64_t n = 0; n < per_producer; ++n) {
+                TelemetryMessage msg = make_item(static_cast<uint32_t>(p), n);
+                if (mode == Mode::MUTEX) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    queue->push(msg);
+                } else {
+                    queue->push(msg);
+                }
+            }
+            done.fetch_add(1, std::memory_order_release);
+        });
+    }
+    for (auto& t : threads) t.join();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    consumer.join();
+    free(memory);
+
+    result.items_per_s = producers * static_cast<double>(per_producer) / secs;
+    return result;
+}
+
+static bool report(const char* what, int producers, uint64_t per_producer, const Result& r) {
+    printf("%-14s %d producer%s  %7.2f M items/s  seen %llu, dropped %llu, %llu torn, %llu out of order\n",
+           what, producers, producers == 1 ? " " : "s", r.items_per_s / 1e6,
+           static_cast<unsigned long long>(r.seen), static_cast<unsigned long long>(r.dropped),
+           static_cast<unsigned long long>(r.torn), static_cast<unsigned long long>(r.disorder));
+    return r.torn == 0 && r.disorder == 0 && r.seen + r.dropped == producers * per_producer;
+}
+
+int main(int argc, char* argv[]) {
+    uint64_t per_producer = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 2000000;
+
+    bool ok = report("single", 1, per_producer, run(Mode::SINGLE, 1, per_producer));
+    for (int producers = 1; producers <= MAX_PRODUCERS; ++producers) {
+        ok &= report("mutex", producers, per_producer, run(Mode::MUTEX, producers, per_producer));
+        ok &= report("multi", producers, per_producer, run(Mode::MULTI, producers, per_producer));
+    }
+
+    printf("%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
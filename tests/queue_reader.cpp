@@ -1,3 +1,4 @@
+#include <chrono>
 #include <csignal>
 #include <cstdio>
 
@@ -21,15 +22,34 @@ int main() {
         return 1;
     }
 
+    // names are optional; without the table only IDs are printed
+    SignalTable* signals = open_signal_table(false);
+
+    // current vehicle state, available even though we attached late
+    if (signals) {
+        uint32_t count = signals->count.load(std::memory_order_acquire);
+        for (uint32_t id = 0; id < count; ++id) {
+            LatestValue latest;
+            if (!signals->read_latest(static_cast<uint16_t>(id), latest)) continue;
+            printf("latest: can_id=0x%03x  %s=%f  (%llu updates)\n", signals->signals[id].can_id,
+                   signals->signals[id].name, latest.value, static_cast<unsigned long long>(latest.updates));
+        }
+    }
+
     std::size_t pos = queue->current_pos();
     printf("Attached to queue at pos %zu. Waiting for messages...\n", pos);
 
     while (running) {
-        queue->consume(pos, [](const TelemetryMessage& msg) {
-            printf("can_id=0x%03x  value=%f\n", msg.can_id, msg.value);
+        if (!queue->wait_for_data(pos, std::chrono::milliseconds(100))) continue;
+        std::size_t dropped = queue->consume(pos, [signals](const TelemetryMessage& msg) {
+            const SignalInfo* info = signals ? signals->info(msg.signal_id) : nullptr;
+            printf("can_id=0x%03x  signal=%u (%s)  value=%f\n", info ? info->can_id : 0, msg.signal_id,
+                   info ? info->name : "?", msg.value);
         });
+        if (dropped) printf("lapped by writer, dropped %zu messages\n", dropped);
     }
 
     close_shared_queue(queue, false);
+    if (signals) close_signal_table(signals, false);
     return 0;
 }
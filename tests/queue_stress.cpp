@@ -0,0 +1,105 @@
+// one writer and several readers in separate processes over the /fsae_telemetry segment
+// readers check that every item is intact and in order, and that items seen + dropped == items written
+// usage: queue_stress [items] [readers]
+
+#include <cstdio>
+#include <cstdlib>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#include "shared_memory.hpp"
+
+// every field is derived from the sequence number so a torn copy is detectable
+static TelemetryMessage make_item(std::size_t i) {
+    TelemetryMessage msg;
+    msg.signal_id = static_cast<uint16_t>(i * 2654435761u >> 16);
+    msg._pad = static_cast<uint16_t>(~i);
+    msg.queue_delay_ns = static_cast<uint32_t>(i);
+    msg.value = static_cast<double>(i);
+    msg.ingest_ns = i;
+    return msg;
+}
+
+static bool intact(const TelemetryMessage& msg) {
+    std::size_t i = static_cast<std::size_t>(msg.value);
+    TelemetryMessage want = make_item(i);
+    return msg.signal_id == want.signal_id && msg._pad == want._pad && msg.queue_delay_ns == want.queue_delay_ns &&
+           msg.ingest_ns == want.ingest_ns;
+}
+
+static int run_writer(std::size_t total) {
+    TelemetryQueue* queue = open_shared_queue(false);
+    if (!queue) return 1;
+    for (std::size_t i = 0; i < total; ++i) queue->push(make_item(i));
+    close_shared_queue(queue, false);
+    return 0;
+}
+
+// reader n spins n * 64 iterations per item, so higher readers get lapped more
+// even readers use consume(), odd readers use peek_batch()/commit()
+static int run_reader(int n, std::size_t total) {
+    TelemetryQueue* queue = open_shared_queue(false);
+    if (!queue) return 1;
+
+    std::size_t pos = 0;
+    std::size_t seen = 0, dropped = 0, torn = 0, disorder = 0;
+    double last = -1.0;
+
+    auto check = [&](const TelemetryMessage& msg) {
+        if (!intact(msg)) ++torn;
+        if (msg.value <= last) ++disorder;
+        last = msg.value;
+        ++seen;
+        for (volatile int spin = 0; spin < n * 64; spin = spin + 1) {}
+    };
+
+    std::vector<TelemetryMessage> held;
+    while (pos < total) {
+        if (n % 2 == 0) {
+            dropped += queue->consume(pos, check);
+            continue;
+        }
+
+        // hold on to the views while "processing", then keep only what commit vouches for
+        auto batch = queue->peek_batch(pos, 1024);
+        held.assign(batch.first, batch.first + batch.first_len);
+        held.insert(held.end(), batch.second, batch.second + batch.second_len);
+        for (volatile int spin = 0; spin < n * 64; spin = spin + 1) {}
+        std::size_t overwritten = queue->commit(pos, batch);
+
+        dropped += batch.dropped + overwritten;
+        for (std::size_t i = overwritten; i < held.size(); ++i) check(held[i]);
+    }
+
+    printf("reader %d: %zu seen, %zu dropped, %zu torn, %zu out of order\n", n, seen, dropped, torn, disorder);
+    fflush(stdout);
+    close_shared_queue(queue, false);
+    return (torn == 0 && disorder == 0 && seen + dropped == total) ? 0 : 1;
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t total = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 20000000;
+    int readers = (argc > 2) ? std::atoi(argv[2]) : 4;
+
+    TelemetryQueue* queue = open_shared_queue(true);
+    if (!queue) {
+        std::perror("Failed to open shared memory queue");
+        return 1;
+    }
+
+    for (int n = 0; n < readers; ++n) {
+        if (fork() == 0) _exit(run_reader(n, total));
+    }
+    if (fork() == 0) _exit(run_writer(total));
+
+    int failures = 0;
+    int status;
+    while (wait(&status) > 0) {
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) ++failures;
+    }
+
+    close_shared_queue(queue, true);
+    printf("%s\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,82 @@
+// wakeup latency and idle CPU of a consumer blocked in wait_for_data
+// a writer process pushes one stamped item per interval; the reader measures push -> wakeup
+// usage: queue_wait_bench [items] [interval_us]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#include "shared_memory.hpp"
+#include "latency_histogram.hpp"
+
+static double now_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t total = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 2000;
+    long interval_us = (argc > 2) ? std::atol(argv[2]) : 1000;
+
+    TelemetryQueue* queue = open_shared_queue(true);
+    if (!queue) {
+        std::perror("Failed to open shared memory queue");
+        return 1;
+    }
+
+    pid_t writer = fork();
+    if (writer == 0) {
+        // give the reader time to block before the first push
+        usleep(50000);
+        for (std::size_t i = 0; i < total; ++i) {
+            TelemetryMessage msg{};
+            msg.signal_id = static_cast<uint16_t>(i);
+            msg.ingest_ns = monotonic_ns();
+            msg.value = static_cast<double>(msg.ingest_ns);
+            queue->push(msg);
+            usleep(interval_us);
+        }
+        _exit(0);
+    }
+
+    std::vector<double> latency;
+    LatencyHistogram hist;
+    latency.reserve(total);
+    std::size_t pos = 0;
+
+    rusage before;
+    getrusage(RUSAGE_SELF, &before);
+    double start = now_ns();
+
+    while (latency.size() < total) {
+        if (!queue->wait_for_data(pos, std::chrono::seconds(1))) continue;
+        uint64_t woke = monotonic_ns();
+        queue->consume(pos, [&](const TelemetryMessage& msg) {
+            latency.push_back(static_cast<double>(woke - msg.ingest_ns));
+            hist.record_since(msg.ingest_ns, woke);
+        });
+    }
+
+    double wall = (now_ns() - start) / 1e9;
+    rusage after;
+    getrusage(RUSAGE_SELF, &after);
+    double cpu = (after.ru_utime.tv_sec - before.ru_utime.tv_sec) + (after.ru_stime.tv_sec - before.ru_stime.tv_sec)
+               + ((after.ru_utime.tv_usec - before.ru_utime.tv_usec) + (after.ru_stime.tv_usec - before.ru_stime.tv_usec)) / 1e6;
+
+    waitpid(writer, nullptr, 0);
+    close_shared_queue(queue, true);
+
+    std::sort(latency.begin(), latency.end());
+    auto pct = [&](double p) { return latency[static_cast<std::size_t>(p * (latency.size() - 1))] / 1000.0; };
+    printf("wakeup latency: p50 %.1f us  p99 %.1f us  max %.1f us\n", pct(0.5), pct(0.99), pct(1.0));
+    print_latency("histogram", hist);
+    printf("reader cpu: %.2f%% of one core over %.2f s\n", 100.0 * cpu / wall, wall);
+    return 0;
+}
@@ -0,0 +1,132 @@
+// hot reload under load: an ingest thread decodes synthetic frames nonstop while the main
+// thread compiles and publishes a new decoder every millisecond
+// reports compile time, publish -> in-use latency, and the gaps between ingest batches
+// (on a single core the gap tail is scheduler time slices, not the reload)
+// first checks, single-threaded, that a swap is seen even when the new decoder reuses the
+// address of one already freed
+// usage: reload_bench [reloads]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "bus_reader.hpp"
+#include "bench_util.hpp"
+
+// a config about the size of a full car DBC: 200 IDs, 8 signals each
+static FrameMap make_frames(int variant, uint32_t ids = 200) {
+    FrameMap frames;
+    for (uint32_t n = 0; n < ids; ++n) {
+        auto& channels = frames[0x100 + n];
+        for (int k = 0; k < 8; ++k) {
+            ChannelConfig cfg = make_channel("sig_" + std::to_string(n) + "_" + std::to_string(k), k * 8, 8);
+            cfg.scale = 1.0 + variant;
+            cfg.signal_id = static_cast<uint16_t>(k);
+            channels.push_back(cfg);
+        }
+    }
+    return frames;
+}
+
+// publish D2, let the bus thread use it, publish D3 and free D2 before the bus thread has seen
+// D3, then publish a larger D4 (which malloc tends to place where D2 was): the bus thread must
+// still count two swaps and size its publish gates for D4
+static bool address_reuse(TelemetryPublisher& publisher, TraceRing& trace, BusStats& bus) {
+    BusIngest ingest(publisher, bus, trace);
+    ingest.set_decoder(std::make_unique<FrameDecoder>(make_frames(1, 4)));
+    ingest.sync();
+    ingest.set_decoder(std::make_unique<FrameDecoder>(make_frames(2, 4)));
+    ingest.reclaim();
+    auto d4 = std::make_unique<FrameDecoder>(make_frames(3, 64));
+    ingest.set_decoder(std::move(d4));
+    uint64_t before = bus.config_swaps.load();
+    ingest.sync();
+
+    CanRxFrame rx[CAN_RX_BATCH];
+    memset(rx, 0, sizeof(rx));
+    for (int i = 0; i < CAN_RX_BATCH; ++i) {
+        rx[i].frame.can_id = 0x100 + 63 - (i % 8);
+        rx[i].frame.len = 8;
+    }
+    uint32_t published = ingest.process(rx, CAN_RX_BATCH);
+    bool ok = bus.config_swaps.load() == before + 1 && published == CAN_RX_BATCH * 8;
+    printf("freed decoder's address reused: swap %s, %u signals published\n",
+           bus.config_swaps.load() == before + 1 ? "seen" : "MISSED", published);
+    ingest.reclaim();
+    return ok;
+}
+
+int main(int argc, char* argv[]) {
+    int reloads = (argc > 1) ? std::atoi(argv[1]) : 1000;
+
+    const std::size_t capacity = 16384;
+    void* memory = aligned_alloc(64, (TelemetryQueue::bytes_for(capacity) + 63) & ~std::size_t{63});
+    TelemetryQueue* queue = TelemetryQueue::create(memory, capacity);
+    static SignalTable signals;
+    static StatsSegment stats;
+    BusStats& bus = stats.reader.buses[0];
+
+    TelemetryPublisher publisher(*queue, signals, stats.reader);
+    TraceRing trace;
+    bool reuse_ok = address_reuse(publisher, trace, stats.reader.buses[1]);
+    BusIngest ingest(publisher, bus, trace);
+    ingest.set_decoder(std::make_unique<FrameDecoder>(make_frames(0)));
+
+    std::atomic<bool> running{true};
+    LatencyHistogram gaps;
+    uint64_t batches = 0;
+    std::thread reader([&] {
+        CanRxFrame rx[CAN_RX_BATCH];
+        memset(rx, 0, sizeof(rx));
+        for (int i = 0; i < CAN_RX_BATCH; ++i) {
+            rx[i].frame.can_id = 0x100 + i * 3;
+            rx[i].frame.len = 8;
+        }
+        uint64_t last = monotonic_ns();
+        while (running.load(std::memory_order_relaxed)) {
+            ingest.process(rx, CAN_RX_BATCH);
+            uint64_t now = monotonic_ns();
+            gaps.record_since(last, now);
+            last = now;
+            ++batches;
+        }
+    });
+
+    LatencyHistogram compile, swap;
+    std::size_t pending_max = 0;
+    uint64_t swaps_seen = 0;
+    for (int r = 1; r <= reloads; ++r) {
+        uint64_t start = monotonic_ns();
+        auto decoder = std::make_unique<FrameDecoder>(make_frames(r));
+        compile.record_since(start, monotonic_ns());
+        ingest.set_decoder(std::move(decoder));
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        uint64_t swaps = bus.config_swaps.load(std::memory_order_relaxed);
+        if (swaps != swaps_seen) {
+            swap.record(bus.swap_latency_ns.load(std::memory_order_relaxed));
+            swaps_seen = swaps;
+        }
+        pending_max = std::max(pending_max, ingest.reclaim());
+    }
+
+    running.store(false, std::memory_order_relaxed);
+    reader.join();
+    std::size_t left = ingest.reclaim();
+
+    print_latency("compile", compile);
+    print_latency("publish->in use", swap);
+    print_latency("batch gap", gaps);
+    printf("%llu batches\n", static_cast<unsigned long long>(batches));
+    printf("retired decoders: at most %zu waiting, %zu left after the reader stopped\n", pending_max, left);
+
+    free(memory);
+    bool ok = reuse_ok && swaps_seen > 0 && left == 0;
+    printf("%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}